@@ -0,0 +1,271 @@
+/*------------------------------------------------------/
+/ Copyright (c) 2026, Elehobica
+/ Released under the BSD-2-Clause
+/ refer to https://opensource.org/licenses/BSD-2-Clause
+/------------------------------------------------------*/
+
+// Host benchmark of the library hot paths: the cases of samples/battery_op_bench on the SDK
+// stand-in, plus the dormant entry / exit sequence, which the stand-in wakes at once. Each case
+// is timed in ns per operation with the host's steady clock and its heap allocations are
+// counted; the result is printed as the same JSON as the on-target benchmark, with an "allocs"
+// field per case (see host/README.md).
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "host_sdk.h"
+#include "pico_battery_op.h"
+
+#if PICO_RP2350
+#define PLATFORM_NAME "host-rp2350"
+#else
+#define PLATFORM_NAME "host-rp2040"
+#endif
+
+// Fixed board pins (see pico_battery_op.cpp)
+static const uint PIN_USB_POWER_DETECT = 24;
+static const uint ADC_INPUT_BATT = 3;
+static const uint ADC_INPUT_TEMP = 4;
+
+// Number of timed runs per case (odd, so the median is a single sample) and calls per run: a
+// call is far below the clock resolution, so each run times a batch.
+static const int DEFAULT_RUNS = 101;
+static const int MAX_RUNS = 1001;
+static const int BATCH = 1000;
+// Reported like the on-target cycles of a 1 GHz clock: min / median / max are ns per call.
+static const uint32_t CLK_HZ = 1000000000;
+
+// === Allocation counter ==================================================
+// Every heap allocation made while a case runs. operator new / new[] are replaced here; on
+// Linux malloc / calloc / realloc are wrapped at link time as well (-Wl,--wrap, see
+// CMakeLists.txt), which also catches the C allocations of the library and the stand-in.
+static uint64_t _allocs = 0;
+
+#if PBO_BENCH_WRAP_MALLOC
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t num, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size)
+{
+    _allocs++;
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t num, size_t size)
+{
+    _allocs++;
+    return __real_calloc(num, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size)
+{
+    _allocs++;
+    return __real_realloc(ptr, size);
+}
+}
+#define RAW_MALLOC __real_malloc
+#else
+#define RAW_MALLOC malloc
+#endif
+
+static void* _counted_new(size_t size)
+{
+    _allocs++;
+    void* p = RAW_MALLOC(size ? size : 1);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new(size_t size) { return _counted_new(size); }
+void* operator new[](size_t size) { return _counted_new(size); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+// === Measurement =========================================================
+static uint32_t samples[MAX_RUNS];
+static int num_runs = DEFAULT_RUNS;
+static uint32_t overhead = 0; // ns per call of an empty case, subtracted from each sample
+static bool first_case = true;
+static bool allocated = false;
+
+// ns per call of func over one batch
+static uint32_t measure(void (*func)(void))
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < BATCH; i++) {
+        func();
+    }
+    auto end = std::chrono::steady_clock::now();
+    uint64_t ns = (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / BATCH;
+    return (ns > overhead) ? (uint32_t) (ns - overhead) : 0;
+}
+
+// Run a case num_runs times and print its min / median / max ns and allocations per call as
+// one JSON object.
+static void run_case(const char* name, void (*func)(void))
+{
+    uint64_t allocs_from = _allocs;
+    for (int i = 0; i < num_runs; i++) {
+        samples[i] = measure(func);
+    }
+    uint64_t allocs = _allocs - allocs_from;
+    std::sort(samples, samples + num_runs);
+    uint32_t median = samples[num_runs / 2];
+    printf("%s    {\"name\": \"%s\", \"min\": %lu, \"median\": %lu, \"max\": %lu, \"median_ns\": %lu, \"allocs\": %.3f}",
+           first_case ? "" : ",\n", name,
+           (unsigned long) samples[0], (unsigned long) median, (unsigned long) samples[num_runs - 1],
+           (unsigned long) median, (double) allocs / ((double) num_runs * BATCH));
+    first_case = false;
+    allocated |= (allocs != 0);
+}
+
+// === Cases ===============================================================
+static void case_empty(void)
+{
+}
+
+// Repeating-timer ISR body: _timer_callback_adc() -> _update_button_action() (+ battery check
+// once per interval, which shows up in max).
+static void case_timer_tick(void)
+{
+    pbo_bench_timer_tick();
+}
+
+// _monitor_battery_voltage(): ADC read and conversion.
+static void case_battery_sample(void)
+{
+    pbo_bench_sample_battery();
+}
+
+// pbo_process() in PboStateActive with nothing pending (the main-loop steady state).
+static void case_process_active(void)
+{
+    pbo_process();
+}
+
+static void timer_nop(void)
+{
+}
+
+// pbo_timer_start() + pbo_timer_stop() of one timer into a table with PBO_MAX_TIMERS - 1 running
+// (insert scans for the last free slot).
+static void case_timer_start(void)
+{
+    pbo_timer_stop(pbo_timer_start(1000, 100, timer_nop));
+}
+
+// One coalesced batch with PBO_MAX_TIMERS - 1 timers expiring together (fire-time scan, then
+// reschedule and an empty callback each).
+static void case_timer_expire(void)
+{
+    pbo_bench_expire_timers();
+}
+
+// Timer throughput against the table fill: the cases below stop the background timers first.
+static int background[PBO_MAX_TIMERS];
+static int num_background = 0;
+
+static void background_timers(int n)
+{
+    while (num_background > 0) {
+        pbo_timer_stop(background[--num_background]);
+    }
+    while (num_background < n) {
+        background[num_background++] = pbo_timer_start(60 * 60 * 1000, 1000, timer_nop);
+    }
+}
+
+// PBO_MAX_TIMERS inserts into an empty table, then every one stopped.
+static void case_timer_fill(void)
+{
+    int ids[PBO_MAX_TIMERS];
+    for (int i = 0; i < PBO_MAX_TIMERS; i++) {
+        ids[i] = pbo_timer_start(1000, 100, timer_nop);
+    }
+    for (int i = 0; i < PBO_MAX_TIMERS; i++) {
+        pbo_timer_stop(ids[i]);
+    }
+}
+
+// Low-leakage sweep of every non-reserved GPIO.
+static void case_low_leakage(void)
+{
+    pbo_dormant_set_low_leakage(0);
+}
+
+// A Sleep from on_enter_dormant() to on_exit_dormant(): statistics, clocks, the battery burst
+// on wake and the restore, with a dormant period of zero length.
+static void case_dormant_cycle(void)
+{
+    pbo_bench_dormant_cycle();
+}
+
+static int _usage(const char* prog)
+{
+    fprintf(stderr, "usage: %s [--runs N]\n", prog);
+    return 2;
+}
+
+int main(int argc, char** argv)
+{
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            num_runs = atoi(argv[++i]);
+            if (num_runs < 1 || num_runs > MAX_RUNS) {
+                return _usage(argv[0]);
+            }
+        } else {
+            return _usage(argv[0]);
+        }
+    }
+
+    // on battery (no USB) at 3.9 V, so the dormant cycle resumes instead of shutting down
+    pbo_config_t cfg = pbo_get_default_config();
+    host_reset();
+    host_gpio_set_input(PIN_USB_POWER_DETECT, false);
+    host_adc_set(ADC_INPUT_BATT, (uint16_t) lroundf((3.9f - cfg.batt_calib_coef_b) / cfg.batt_calib_coef_a / 3.3f * 4095.0f));
+    host_adc_set(ADC_INPUT_TEMP, 876); // 0.706 V: 27 degC
+    pbo_init(&cfg);
+    pbo_start();
+    // Run the state machine as PboStateActive directly, as the on-target benchmark does.
+    pbo_bench_set_state(PboStateActive);
+    background_timers(PBO_MAX_TIMERS - 1); // never due on their own while benchmarking
+
+    overhead = 0;
+    overhead = measure(case_empty);
+
+    printf("{\n");
+    printf("  \"platform\": \"%s\",\n", PLATFORM_NAME);
+    printf("  \"clk_sys_hz\": %lu,\n", (unsigned long) CLK_HZ);
+    printf("  \"runs\": %d,\n", num_runs);
+    printf("  \"overhead\": %lu,\n", (unsigned long) overhead);
+    printf("  \"cases\": [\n");
+    run_case("timer_tick", case_timer_tick);
+    run_case("battery_sample", case_battery_sample);
+    run_case("process_active", case_process_active);
+    run_case("timer_start", case_timer_start);
+    run_case("timer_expire", case_timer_expire);
+    run_case("low_leakage", case_low_leakage);
+    run_case("dormant_cycle", case_dormant_cycle);
+    background_timers(0);
+    run_case("timer_fill", case_timer_fill);
+    background_timers(1);
+    run_case("timer_expire_one", case_timer_expire); // a batch of a single timer
+    background_timers(PBO_MAX_TIMERS);
+    run_case("timer_expire_full", case_timer_expire); // and of a full table
+    printf("\n  ]\n}\n");
+
+    // the hot paths must not touch the heap
+    return allocated ? 1 : 0;
+}
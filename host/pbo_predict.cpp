@@ -0,0 +1,807 @@
+/*------------------------------------------------------/
+/ Copyright (c) 2026, Elehobica
+/ Released under the BSD-2-Clause
+/ refer to https://opensource.org/licenses/BSD-2-Clause
+/------------------------------------------------------*/
+
+// Battery-life predictor: runs the real pico_battery_op state machine on the host SDK
+// stand-in against a usage script (or a recorded trace), drains a cell model with the
+// per-mode currents and feeds the cell voltage back into the ADC stand-in. Reports the time to
+// the low-battery shutdown, the projected runtime and the residency, for one configuration or
+// a sweep of pbo_config_t members (see host/README.md).
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "host_sdk.h"
+#include "pico_battery_op.h"
+
+// Fixed board pins (see pico_battery_op.cpp)
+static const uint PIN_DCDC_PSM_CTRL = 23;
+static const uint PIN_USB_POWER_DETECT = 24;
+static const uint ADC_INPUT_BATT = 3;
+static const uint ADC_INPUT_TEMP = 4;
+static const uint64_t TICK_US = 50000;         // main loop cadence (the library's 20 Hz sampler)
+static const uint64_t DAY_US = 86400ull * 1000000;
+
+// === Usage script ========================================================
+typedef enum {
+    EvPower = 0,  // POWER gesture (arg: button_action_t ButtonPower*)
+    EvUser,       // USER gesture  (arg: button_action_t ButtonUser*)
+    EvUsbOn,
+    EvUsbOff,
+    EvDcdc,       // application sets the DC/DC PSM control: PWM (arg 1) / PFM (arg 0)
+    EvActivity    // pbo_notify_activity()
+} event_kind_t;
+
+typedef struct {
+    uint64_t at_us;  // within the period
+    event_kind_t kind;
+    int arg;
+} script_event_t;
+
+typedef struct {
+    std::vector<script_event_t> events; // sorted by at_us
+    uint64_t period_us;                 // the script repeats with this period
+} script_t;
+
+static const char* const GESTURES[] = { "single", "double", "triple", "long", "longlong" };
+
+static int _parse_gesture(const char* s)
+{
+    for (int i = 0; i < 5; i++) {
+        if (strcmp(s, GESTURES[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// "HH:MM[:SS] event [arg]" per line, '#' comments; repeated every day.
+static bool _load_script(const char* path, script_t* script)
+{
+    FILE* fp = fopen(path, "r");
+    if (fp == nullptr) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+    char line[256];
+    int lineno = 0;
+    script->period_us = DAY_US;
+    while (fgets(line, sizeof(line), fp) != nullptr) {
+        lineno++;
+        char* hash = strchr(line, '#');
+        if (hash != nullptr) {
+            *hash = '\0';
+        }
+        char when[32], what[32], arg[32] = "";
+        int n = sscanf(line, "%31s %31s %31s", when, what, arg);
+        if (n <= 0) {
+            continue;
+        }
+        unsigned h = 0, m = 0, s = 0;
+        if (n < 2 || sscanf(when, "%u:%u:%u", &h, &m, &s) < 2) {
+            fprintf(stderr, "%s:%d: expected 'HH:MM[:SS] event [arg]'\n", path, lineno);
+            fclose(fp);
+            return false;
+        }
+        script_event_t ev = { ((uint64_t) h * 3600 + m * 60 + s) * 1000000, EvActivity, 0 };
+        int g = _parse_gesture(arg);
+        if (strcmp(what, "power") == 0 && g >= 0) {
+            ev.kind = EvPower;
+            ev.arg = ButtonPowerSingle + g;
+        } else if (strcmp(what, "user") == 0 && g >= 0) {
+            ev.kind = EvUser;
+            ev.arg = ButtonUserSingle + g;
+        } else if (strcmp(what, "usb") == 0 && (strcmp(arg, "on") == 0 || strcmp(arg, "off") == 0)) {
+            ev.kind = (strcmp(arg, "on") == 0) ? EvUsbOn : EvUsbOff;
+        } else if (strcmp(what, "dcdc") == 0 && (strcmp(arg, "pfm") == 0 || strcmp(arg, "pwm") == 0)) {
+            ev.kind = EvDcdc;
+            ev.arg = (strcmp(arg, "pwm") == 0);
+        } else if (strcmp(what, "activity") == 0) {
+            ev.kind = EvActivity;
+        } else {
+            fprintf(stderr, "%s:%d: unknown event '%s %s'\n", path, lineno, what, arg);
+            fclose(fp);
+            return false;
+        }
+        if (ev.at_us >= DAY_US) {
+            fprintf(stderr, "%s:%d: time beyond 24:00:00\n", path, lineno);
+            fclose(fp);
+            return false;
+        }
+        script->events.push_back(ev);
+    }
+    fclose(fp);
+    for (size_t i = 1; i < script->events.size(); i++) {
+        for (size_t j = i; j > 0 && script->events[j].at_us < script->events[j - 1].at_us; j--) {
+            std::swap(script->events[j], script->events[j - 1]);
+        }
+    }
+    return true;
+}
+
+// pbo_trace_dump() output: button records become gestures at their time stamps, each
+// dormant_exit (Power switch) a POWER push. The system timer the stamps come from stops while
+// dormant, so each dormant period is replayed as dormant_ms.
+static bool _load_trace(const char* path, uint64_t dormant_ms, script_t* script)
+{
+    FILE* fp = fopen(path, "r");
+    if (fp == nullptr) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+    char line[256];
+    uint64_t shift_us = 0;
+    uint64_t last_us = 0;
+    while (fgets(line, sizeof(line), fp) != nullptr) {
+        unsigned long ts, delta, arg;
+        char name[32];
+        if (sscanf(line, "%lu us (+%lu) %31s %lu", &ts, &delta, name, &arg) != 4) {
+            continue;
+        }
+        uint64_t at_us = ts + shift_us;
+        if (strcmp(name, "button") == 0 && arg < ButtonOthers) {
+            script_event_t ev = { at_us, (arg <= ButtonPowerLongLong) ? EvPower : EvUser, (int) arg };
+            script->events.push_back(ev);
+        } else if (strcmp(name, "dormant_exit") == 0 && arg == 0) {
+            shift_us += dormant_ms * 1000;
+            at_us += dormant_ms * 1000;
+            script_event_t ev = { at_us, EvPower, ButtonPowerSingle };
+            script->events.push_back(ev);
+        } else {
+            continue;
+        }
+        last_us = at_us;
+    }
+    fclose(fp);
+    if (script->events.empty()) {
+        fprintf(stderr, "%s: no button / dormant_exit records\n", path);
+        return false;
+    }
+    script->period_us = last_us + 60 * 1000000; // repeat the trace after a minute of quiet
+    return true;
+}
+
+// === Switch waveforms ====================================================
+// Press / release edges of one gesture: presses of 150 ms, 150 ms apart, Long held 1.5 s,
+// LongLong held 3 s.
+typedef struct {
+    uint64_t at_us;
+    uint pin;
+    bool level;
+} edge_t;
+
+static void _gesture_edges(int action, uint pin, uint64_t at_us, std::vector<edge_t>* edges)
+{
+    int g = (action >= ButtonUserSingle) ? action - ButtonUserSingle : action;
+    const uint64_t press_us = 150000;
+    if (g <= 2) {
+        for (int i = 0; i <= g; i++) {
+            edges->push_back({ at_us + 2 * i * press_us, pin, false });
+            edges->push_back({ at_us + (2 * i + 1) * press_us, pin, true });
+        }
+    } else {
+        uint64_t hold_us = (g == 3) ? 1500000 : 3000000;
+        edges->push_back({ at_us, pin, false });
+        edges->push_back({ at_us + hold_us, pin, true });
+    }
+}
+
+// === Cell model ==========================================================
+// Li-ion open-circuit voltage over the state of charge, plus an internal resistance.
+typedef struct {
+    float soc;
+    float ocv;
+} ocv_point_t;
+
+static const ocv_point_t OCV[] = {
+    { 0.00f, 2.80f }, { 0.02f, 3.20f }, { 0.05f, 3.45f }, { 0.10f, 3.60f }, { 0.20f, 3.68f },
+    { 0.40f, 3.77f }, { 0.60f, 3.87f }, { 0.80f, 4.00f }, { 1.00f, 4.18f }
+};
+
+typedef struct {
+    float capacity_mah;
+    float r_ohm;          // internal resistance
+    float charge_ma;      // charger current with USB present
+    float active_ma;      // per-mode board currents (pbo_current_model_t)
+    float active_psm_ma;
+    float sleep_ma;
+    float charging_ma;    // drawn from the cell while Charging (normally 0)
+    float off_ma;         // hardware Stand-by (POWER_KEEP released, no USB)
+} cell_model_t;
+
+static float _ocv(double soc)
+{
+    const size_t n = sizeof(OCV) / sizeof(OCV[0]);
+    if (soc <= OCV[0].soc) {
+        return OCV[0].ocv;
+    }
+    for (size_t i = 1; i < n; i++) {
+        if (soc <= OCV[i].soc) {
+            float r = (float) (soc - OCV[i - 1].soc) / (OCV[i].soc - OCV[i - 1].soc);
+            return OCV[i - 1].ocv + r * (OCV[i].ocv - OCV[i - 1].ocv);
+        }
+    }
+    return OCV[n - 1].ocv;
+}
+
+// === Simulation ==========================================================
+typedef enum {
+    ModeActive = 0,  // running (Idle or Active), DC/DC in PWM mode
+    ModeActivePsm,   // running, DC/DC in PFM mode
+    ModeSleep,       // dormant, POWER_KEEP held
+    ModeCharging,    // dormant with USB
+    ModeOff,         // powered off (hardware Stand-by, or a drained cell)
+    NUM_MODES
+} mode_t_;
+
+static const char* const MODE_NAMES[NUM_MODES] = { "active", "active_psm", "sleep", "charging", "off" };
+
+typedef struct {
+    double days;               // simulated
+    double low_batt_days;      // time of the low-battery shutdown, < 0 if none
+    double runtime_days;       // capacity / average discharge current
+    double avg_ma;             // average cell discharge current (USB time excluded)
+    double residency[NUM_MODES]; // fraction of the simulated time
+    uint32_t sleeps;
+    uint32_t boots;
+} result_t;
+
+typedef struct {
+    const script_t* script;
+    const cell_model_t* cell;
+    pbo_config_t cfg;
+    // state
+    double soc;                // state of charge, 0..1 (double: a 50 ms tick moves it by ~1e-7)
+    bool usb;
+    bool off;
+    bool low_batt_shutdown;
+    size_t next_ev;            // next script event within the current period
+    uint64_t period_start_us;  // wall time of the current period
+    std::vector<edge_t> edges; // pending switch edges, any order
+    uint64_t last_edge_us;     // wall time of the last switch edge applied
+    uint64_t exact_until_us;   // tick-exact until then after a skip (a battery sample falls in it)
+    uint64_t skip_us;          // longest quiet span skipped at once, 0 = tick-exact throughout
+    bool log;                  // print the power events
+    double mode_us[NUM_MODES];
+    double drawn_mas;          // discharge [mA*s] without USB
+    double battery_s;          // time on battery [s]
+    uint64_t wall_us;          // always-on time of the simulation
+    uint32_t sleeps;
+    uint32_t boots;
+} sim_t;
+
+static sim_t* _sim = nullptr; // for the dormant hook and callbacks
+
+static void _log(const sim_t* sim, const char* fmt, ...)
+{
+    if (!sim->log) {
+        return;
+    }
+    uint64_t s = sim->wall_us / 1000000;
+    printf("day %4llu %02u:%02u:%02u  ", (unsigned long long) (s / 86400), (unsigned) (s / 3600 % 24),
+           (unsigned) (s / 60 % 60), (unsigned) (s % 60));
+    va_list ap;
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+    printf(" (%.1f%%, %.3f V)\n", sim->soc * 100.0f, _ocv(sim->soc));
+}
+
+static void _on_state_changed(pbo_state_t new_state, pbo_state_t prev_state)
+{
+    static const char* const names[] = { "Idle", "Active", "ActiveEco" };
+    if (_sim->off) {
+        return; // the library runs on after a power loss in dormant; the board does not
+    }
+    _log(_sim, "state %s -> %s", names[prev_state], names[new_state]);
+    if (new_state == PboStateIdle && pbo_get_battery_level() > _sim->cfg.battery_levels_num) {
+        _sim->low_batt_shutdown = true; // shut down on a wake below the cutoff (no deferred)
+    }
+}
+
+static void _on_deferred(pbo_deferred_reason_t reason)
+{
+    static const char* const names[] = { "none", "sleep", "shutdown", "low_battery", "charge" };
+    _log(_sim, "deferred %s", names[reason]);
+    if (reason == PboDeferredLowBattery) {
+        _sim->low_batt_shutdown = true;
+    }
+}
+
+static void _set_cell_adc(sim_t* sim, float load_ma)
+{
+    float v = _ocv(sim->soc) + (sim->usb ? sim->cell->charge_ma : -load_ma) * sim->cell->r_ohm / 1000.0f;
+    float pin_v = (v - sim->cfg.batt_calib_coef_b) / sim->cfg.batt_calib_coef_a;
+    long raw = lroundf(pin_v / 3.3f * 4095.0f);
+    host_adc_set(ADC_INPUT_BATT, (uint16_t) (raw < 0 ? 0 : raw > 4095 ? 4095 : raw));
+}
+
+static float _mode_ma(const sim_t* sim, int mode)
+{
+    const cell_model_t* c = sim->cell;
+    switch (mode) {
+        case ModeActive:    return c->active_ma;
+        case ModeActivePsm: return c->active_psm_ma;
+        case ModeSleep:     return c->sleep_ma;
+        case ModeCharging:  return c->charging_ma;
+        default:            return c->off_ma;
+    }
+}
+
+// Spend us in mode: residency, cell charge / discharge, ADC.
+static void _spend(sim_t* sim, int mode, uint64_t us)
+{
+    double s = (double) us / 1e6;
+    float ma = _mode_ma(sim, mode);
+    sim->mode_us[mode] += (double) us;
+    if (sim->usb) {
+        sim->soc += sim->cell->charge_ma * s / 3600.0 / sim->cell->capacity_mah;
+        if (sim->soc > 1.0) {
+            sim->soc = 1.0;
+        }
+    } else {
+        sim->soc -= ma * s / 3600.0 / sim->cell->capacity_mah;
+        if (sim->soc < 0.0) {
+            sim->soc = 0.0;
+        }
+        sim->drawn_mas += ma * s;
+        sim->battery_s += s;
+    }
+    sim->wall_us += us;
+    _set_cell_adc(sim, ma);
+}
+
+static uint64_t _next_event_at(const sim_t* sim)
+{
+    const script_t* sc = sim->script;
+    if (sim->next_ev < sc->events.size()) {
+        return sim->period_start_us + sc->events[sim->next_ev].at_us;
+    }
+    return sim->period_start_us + sc->period_us + (sc->events.empty() ? 0 : sc->events[0].at_us);
+}
+
+static const script_event_t* _peek_event(const sim_t* sim)
+{
+    const script_t* sc = sim->script;
+    return &sc->events[(sim->next_ev < sc->events.size()) ? sim->next_ev : 0];
+}
+
+static const script_event_t* _pop_event(sim_t* sim)
+{
+    const script_t* sc = sim->script;
+    if (sim->next_ev >= sc->events.size()) {
+        sim->period_start_us += sc->period_us;
+        sim->next_ev = 0;
+    }
+    return &sc->events[sim->next_ev++];
+}
+
+static void _set_usb(sim_t* sim, bool usb)
+{
+    sim->usb = usb;
+    host_gpio_set_input(PIN_USB_POWER_DETECT, usb);
+}
+
+// Apply the script events due by now (switch edges are queued, the rest applied directly).
+static void _apply_events(sim_t* sim, bool running)
+{
+    while (!sim->script->events.empty() && _next_event_at(sim) <= sim->wall_us) {
+        uint64_t at_us = _next_event_at(sim);
+        const script_event_t* ev = _pop_event(sim);
+        switch (ev->kind) {
+            case EvPower:
+                _gesture_edges(ev->arg, sim->cfg.pin_power_sw, at_us, &sim->edges);
+                break;
+            case EvUser:
+                if (running && sim->cfg.pin_user_sw != PBO_PIN_UNUSED) {
+                    _gesture_edges(ev->arg, sim->cfg.pin_user_sw, at_us, &sim->edges);
+                }
+                break;
+            case EvUsbOn:
+            case EvUsbOff:
+                _set_usb(sim, ev->kind == EvUsbOn);
+                break;
+            case EvDcdc:
+                if (running) {
+                    gpio_put(PIN_DCDC_PSM_CTRL, ev->arg != 0);
+                }
+                break;
+            case EvActivity:
+                if (running) {
+                    pbo_notify_activity();
+                }
+                break;
+        }
+    }
+    for (size_t i = 0; i < sim->edges.size();) {
+        if (sim->edges[i].at_us <= sim->wall_us) {
+            host_gpio_set_input(sim->edges[i].pin, sim->edges[i].level);
+            sim->last_edge_us = sim->wall_us;
+            sim->edges[i] = sim->edges.back();
+            sim->edges.pop_back();
+        } else {
+            i++;
+        }
+    }
+}
+
+// Board power: POWER_KEEP held, or USB present.
+static bool _powered(const sim_t* sim)
+{
+    return sim->usb || host_gpio_output(sim->cfg.pin_power_keep);
+}
+
+// Dormant until the next POWER push or the alarm; USB sessions in between only charge the cell.
+// Losing power (USB unplugged while Charging) ends it too: the board is off from then on.
+static uint64_t _dormant_hook(uint pin, uint64_t alarm_us)
+{
+    sim_t* sim = _sim;
+    sim->sleeps++;
+    _log(sim, "dormant%s", sim->usb ? " (USB)" : "");
+    uint64_t start_us = sim->wall_us;
+    uint64_t alarm_wall_us = (alarm_us == UINT64_MAX) ? UINT64_MAX : start_us + (alarm_us - host_aon_us());
+    (void) pin;
+    while (true) {
+        uint64_t next_us = sim->script->events.empty() ? UINT64_MAX : _next_event_at(sim);
+        uint64_t until_us = (next_us < alarm_wall_us) ? next_us : alarm_wall_us;
+        if (until_us == UINT64_MAX) {
+            until_us = sim->wall_us + DAY_US;
+        }
+        if (until_us > sim->wall_us) {
+            _spend(sim, sim->usb ? ModeCharging : ModeSleep, until_us - sim->wall_us);
+        }
+        if (until_us == alarm_wall_us) {
+            break;
+        }
+        bool wake = (_peek_event(sim)->kind == EvPower);
+        _apply_events(sim, false); // a POWER gesture's first press is the wake edge
+        if (wake) {
+            break;
+        }
+        if (!_powered(sim)) {
+            sim->off = true;
+            break;
+        }
+    }
+    _log(sim, sim->off ? "power lost" : "wake");
+    return sim->wall_us - start_us;
+}
+
+// A quiet span of Active the sampler ticks would not change: switches released and
+// recognized, nothing deferred, the cell away from the thresholds. Skipped up to the next
+// script event, by at most skip_us and a twentieth of the shortest inactivity timer, then
+// followed by a tick-exact batt_check_max_ms so that the skip costs one battery sample at most.
+static uint64_t _quiet_span_us(sim_t* sim, uint64_t end_us)
+{
+    const pbo_config_t* cfg = &sim->cfg;
+    uint64_t span_us = sim->skip_us;
+    if (span_us == 0 || sim->wall_us < sim->exact_until_us || !sim->edges.empty()
+        || sim->wall_us - sim->last_edge_us < 3000000 || pbo_get_deferred(nullptr)) {
+        return 0;
+    }
+    float v = _ocv(sim->soc) - _mode_ma(sim, ModeActive) * sim->cell->r_ohm / 1000.0f;
+    if (!sim->usb && v < cfg->low_battery_threshold + 0.1f) {
+        return 0;
+    }
+    for (uint32_t i = 0; i < cfg->battery_levels_num; i++) {
+        if (fabsf(v - cfg->battery_levels[i]) < 0.1f) {
+            return 0;
+        }
+    }
+    const uint32_t idle_ms[] = { cfg->idle_sleep_ms, cfg->idle_shutdown_ms, cfg->idle_eco_ms };
+    for (uint32_t ms : idle_ms) {
+        if (ms != 0 && (uint64_t) ms * 1000 / 20 < span_us) {
+            span_us = (uint64_t) ms * 1000 / 20;
+        }
+    }
+    uint64_t next_us = sim->script->events.empty() ? end_us : _next_event_at(sim);
+    if (next_us > end_us) {
+        next_us = end_us;
+    }
+    if (next_us <= sim->wall_us + TICK_US) {
+        return 0;
+    }
+    if (next_us - sim->wall_us - TICK_US < span_us) {
+        span_us = next_us - sim->wall_us - TICK_US;
+    }
+    return span_us - span_us % TICK_US;
+}
+
+static void _boot(sim_t* sim)
+{
+    sim->off = false;
+    sim->boots++;
+    _log(sim, "boot%s", sim->usb ? " (USB)" : "");
+    sim->cfg.callbacks.on_deferred = _on_deferred;
+    sim->cfg.callbacks.on_state_changed = _on_state_changed;
+    pbo_init(&sim->cfg);
+    pbo_start();
+}
+
+static bool _run(const script_t* script, const cell_model_t* cell, const pbo_config_t* cfg, double days,
+                 uint64_t skip_ms, bool log, result_t* out)
+{
+    sim_t sim = {};
+    sim.script = script;
+    sim.cell = cell;
+    sim.cfg = *cfg;
+    sim.skip_us = skip_ms * 1000;
+    sim.log = log;
+    sim.soc = 1.0;
+    _sim = &sim;
+
+    host_reset();
+    host_set_dormant_hook(_dormant_hook);
+    host_adc_set(ADC_INPUT_TEMP, 876); // 0.706 V: 27 degC
+    _set_usb(&sim, false);
+    _set_cell_adc(&sim, 0.0f);
+
+    // Power on with a POWER push at 0 s
+    uint64_t end_us = (uint64_t) (days * (double) DAY_US);
+    host_gpio_set_input(sim.cfg.pin_power_sw, false);
+    sim.edges.push_back({ 150000, sim.cfg.pin_power_sw, true });
+    _boot(&sim);
+
+    while (sim.wall_us < end_us && !sim.low_batt_shutdown) {
+        if (sim.off) {
+            // Stand-by until USB or a POWER push brings the board up
+            uint64_t next_us = script->events.empty() ? end_us : _next_event_at(&sim);
+            if (next_us > end_us) {
+                next_us = end_us;
+            }
+            if (next_us > sim.wall_us) {
+                _spend(&sim, ModeOff, next_us - sim.wall_us);
+            }
+            _apply_events(&sim, false);
+            bool sw = gpio_get(sim.cfg.pin_power_sw);
+            if (sim.usb || !sw) {
+                _boot(&sim);
+            }
+            continue;
+        }
+        int mode = gpio_get(PIN_DCDC_PSM_CTRL) ? ModeActive : ModeActivePsm;
+        uint64_t quiet_us = _quiet_span_us(&sim, end_us);
+        if (quiet_us != 0) {
+            _spend(&sim, mode, quiet_us);
+            host_skip_us(quiet_us);
+            sim.exact_until_us = sim.wall_us + (uint64_t) sim.cfg.batt_check_max_ms * 1000 + TICK_US;
+            pbo_process();
+            continue;
+        }
+        _spend(&sim, mode, TICK_US);
+        _apply_events(&sim, true);
+        host_advance_us(TICK_US);
+        pbo_process();
+        if (!sim.off && !_powered(&sim)) {
+            sim.off = true; // POWER_KEEP released without USB: the DC/DC stops
+            _log(&sim, "power off");
+        }
+    }
+
+    out->days = (double) sim.wall_us / (double) DAY_US;
+    out->low_batt_days = sim.low_batt_shutdown ? out->days : -1.0;
+    out->avg_ma = (sim.battery_s > 0) ? sim.drawn_mas / sim.battery_s : 0.0;
+    out->runtime_days = (out->avg_ma > 0) ? cell->capacity_mah / out->avg_ma / 24.0 : INFINITY;
+    for (int m = 0; m < NUM_MODES; m++) {
+        out->residency[m] = sim.mode_us[m] / (double) sim.wall_us;
+    }
+    out->sleeps = sim.sleeps;
+    out->boots = sim.boots;
+    _sim = nullptr;
+    return true;
+}
+
+// === Configuration keys ==================================================
+static bool _parse_action(const char* s, pbo_power_action_t* out)
+{
+    if (strcmp(s, "none") == 0) { *out = PboActionNone; return true; }
+    if (strcmp(s, "sleep") == 0) { *out = PboActionSleep; return true; }
+    if (strcmp(s, "shutdown") == 0) { *out = PboActionShutdown; return true; }
+    return false;
+}
+
+// Set one pbo_config_t member (or cell model current) from "key=value".
+static bool _set_key(pbo_config_t* cfg, cell_model_t* cell, const char* key, const char* value)
+{
+    char* end;
+    double v = strtod(value, &end);
+    bool num = (*value != '\0' && *end == '\0');
+    struct { const char* name; uint32_t* member; } u32_keys[] = {
+        { "sleep_defer_ms", &cfg->sleep_defer_ms }, { "shutdown_defer_ms", &cfg->shutdown_defer_ms },
+        { "charge_defer_ms", &cfg->charge_defer_ms }, { "idle_sleep_ms", &cfg->idle_sleep_ms },
+        { "idle_shutdown_ms", &cfg->idle_shutdown_ms }, { "idle_eco_ms", &cfg->idle_eco_ms },
+        { "power_gestures", &cfg->power_gestures }, { "user_gestures", &cfg->user_gestures },
+        { "pin_user_sw", &cfg->pin_user_sw }, { "max_sleep_ms", &cfg->max_sleep_ms },
+        { "batt_check_min_ms", &cfg->batt_check_min_ms }, { "batt_check_max_ms", &cfg->batt_check_max_ms },
+    };
+    for (auto& k : u32_keys) {
+        if (strcmp(key, k.name) == 0 && num) {
+            *k.member = (uint32_t) v;
+            return true;
+        }
+    }
+    struct { const char* name; pbo_power_action_t* member; } action_keys[] = {
+        { "power_action_single", &cfg->power_action_single }, { "power_action_double", &cfg->power_action_double },
+        { "power_action_triple", &cfg->power_action_triple }, { "power_action_long", &cfg->power_action_long },
+        { "power_action_longlong", &cfg->power_action_longlong },
+    };
+    for (auto& k : action_keys) {
+        if (strcmp(key, k.name) == 0) {
+            return _parse_action(value, k.member);
+        }
+    }
+    struct { const char* name; float* member; } float_keys[] = {
+        { "low_battery_threshold", &cfg->low_battery_threshold },
+        { "capacity_mah", &cell->capacity_mah }, { "r_ohm", &cell->r_ohm }, { "charge_ma", &cell->charge_ma },
+        { "active_ma", &cell->active_ma }, { "active_psm_ma", &cell->active_psm_ma },
+        { "sleep_ma", &cell->sleep_ma }, { "charging_ma", &cell->charging_ma }, { "off_ma", &cell->off_ma },
+    };
+    for (auto& k : float_keys) {
+        if (strcmp(key, k.name) == 0 && num) {
+            *k.member = (float) v;
+            return true;
+        }
+    }
+    if (strcmp(key, "idle_suspend_on_usb") == 0 && num) {
+        cfg->idle_suspend_on_usb = v != 0;
+        return true;
+    }
+    return false;
+}
+
+typedef struct {
+    std::string key;
+    std::vector<std::string> values;
+} sweep_axis_t;
+
+static void _usage()
+{
+    fprintf(stderr,
+        "usage: pbo_predict (--script FILE | --trace FILE [--trace-dormant-ms MS]) [--days N]\n"
+        "                   [--skip-ms MS] [--log] [--set KEY=VALUE]... [--sweep KEY=V1,V2,...]...\n"
+        "KEY: a pbo_config_t member (*_defer_ms, power_action_* = none|sleep|shutdown, idle_*,\n"
+        "     power_gestures, user_gestures, pin_user_sw, max_sleep_ms, batt_check_*_ms,\n"
+        "     low_battery_threshold) or a cell model value (capacity_mah, r_ohm, charge_ma,\n"
+        "     active_ma, active_psm_ma, sleep_ma, charging_ma, off_ma)\n");
+}
+
+int main(int argc, char** argv)
+{
+    script_t script = {};
+    bool have_script = false;
+    double days = 365.0;
+    uint64_t trace_dormant_ms = 3600 * 1000;
+    uint64_t skip_ms = 600 * 1000;
+    bool log = false;
+    const char* trace_path = nullptr;
+    pbo_config_t cfg = pbo_get_default_config();
+    cell_model_t cell = { 2000.0f, 0.15f, 500.0f, 25.0f, 20.0f, 0.8f, 0.0f, 0.01f };
+    std::vector<sweep_axis_t> axes;
+
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        if (strcmp(a, "--log") == 0) {
+            log = true;
+            continue;
+        }
+        const char* v = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (v == nullptr) {
+            _usage();
+            return 2;
+        }
+        i++;
+        if (strcmp(a, "--script") == 0) {
+            if (!_load_script(v, &script)) return 1;
+            have_script = true;
+        } else if (strcmp(a, "--trace") == 0) {
+            trace_path = v;
+        } else if (strcmp(a, "--trace-dormant-ms") == 0) {
+            trace_dormant_ms = strtoull(v, nullptr, 0);
+        } else if (strcmp(a, "--skip-ms") == 0) {
+            skip_ms = strtoull(v, nullptr, 0);
+        } else if (strcmp(a, "--days") == 0) {
+            days = atof(v);
+        } else if (strcmp(a, "--set") == 0 || strcmp(a, "--sweep") == 0) {
+            const char* eq = strchr(v, '=');
+            if (eq == nullptr) {
+                _usage();
+                return 2;
+            }
+            sweep_axis_t axis = { std::string(v, eq - v), {} };
+            std::string rest(eq + 1);
+            size_t pos = 0;
+            while (true) {
+                size_t comma = rest.find(',', pos);
+                axis.values.push_back(rest.substr(pos, comma - pos));
+                if (comma == std::string::npos) break;
+                pos = comma + 1;
+            }
+            if (strcmp(a, "--set") == 0) {
+                if (!_set_key(&cfg, &cell, axis.key.c_str(), axis.values[0].c_str())) {
+                    fprintf(stderr, "bad --set %s\n", v);
+                    return 2;
+                }
+            } else {
+                axes.push_back(axis);
+            }
+        } else {
+            _usage();
+            return 2;
+        }
+    }
+    if (trace_path != nullptr) {
+        if (!_load_trace(trace_path, trace_dormant_ms, &script)) return 1;
+        have_script = true;
+    }
+    if (!have_script) {
+        _usage();
+        return 2;
+    }
+
+    // Cartesian product of the sweep axes
+    size_t combos = 1;
+    int width = 8; // "(as set)"
+    int axes_width = -1;
+    for (auto& ax : axes) {
+        combos *= ax.values.size();
+        size_t longest = 0;
+        for (auto& val : ax.values) {
+            longest = std::max(longest, ax.key.size() + 1 + val.size());
+        }
+        axes_width += 1 + (int) longest;
+    }
+    width = std::max(width, axes_width);
+    printf("%-*s %9s %9s %8s", width, "config", "low_batt", "runtime", "avg");
+    for (int m = 0; m < NUM_MODES; m++) {
+        printf(" %10s", MODE_NAMES[m]);
+    }
+    printf(" %7s\n", "sleeps");
+
+    double sim_days = 0.0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t c = 0; c < combos; c++) {
+        pbo_config_t run_cfg = cfg;
+        cell_model_t run_cell = cell;
+        std::string label;
+        size_t idx = c;
+        for (auto& ax : axes) {
+            const std::string& val = ax.values[idx % ax.values.size()];
+            idx /= ax.values.size();
+            if (!_set_key(&run_cfg, &run_cell, ax.key.c_str(), val.c_str())) {
+                fprintf(stderr, "bad --sweep %s=%s\n", ax.key.c_str(), val.c_str());
+                return 2;
+            }
+            label += (label.empty() ? "" : " ") + ax.key + "=" + val;
+        }
+        if (label.empty()) {
+            label = "(as set)";
+        }
+        result_t r;
+        _run(&script, &run_cell, &run_cfg, days, skip_ms, log, &r);
+        sim_days += r.days;
+        char low[16];
+        if (r.low_batt_days >= 0) {
+            snprintf(low, sizeof(low), "%7.2f d", r.low_batt_days);
+        } else {
+            snprintf(low, sizeof(low), "%9s", "-");
+        }
+        printf("%-*s %9s %7.1f d %5.2f mA", width, label.c_str(), low, r.runtime_days, r.avg_ma);
+        for (int m = 0; m < NUM_MODES; m++) {
+            printf(" %9.2f%%", r.residency[m] * 100.0);
+        }
+        printf(" %7u\n", (unsigned) r.sleeps);
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    fflush(stdout);
+    fprintf(stderr, "%.0f simulated days in %.2f s (%.0f days/s)\n", sim_days, secs, sim_days / secs);
+    return 0;
+}
@@ -0,0 +1,144 @@
+/*------------------------------------------------------/
+/ Copyright (c) 2026, Elehobica
+/ Released under the BSD-2-Clause
+/ refer to https://opensource.org/licenses/BSD-2-Clause
+/------------------------------------------------------*/
+
+// Decoder of binary trace records: pbo_trace_read() output saved by the application as raw
+// 12-byte records (timestamp_us, event, arg; little-endian uint32 each), printed as the same
+// timeline as pbo_trace_dump(), so pbo_predict --trace takes it too. --explain adds the meaning
+// of each arg (see host/README.md).
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "pico_battery_op.h" // built with PBO_TRACE for the record types
+
+static const char* const EVENT_NAMES[] = {
+    "?", "state", "defer_begin", "defer_cancel", "defer_run",
+    "button", "button_dropped", "adc_mv", "dormant_enter", "dormant_exit",
+    "defer_preempt", "defer_queue", "batt_level"
+};
+static const char* const STATE_NAMES[] = { "Idle", "Active", "ActiveEco" };
+static const char* const REASON_NAMES[] = { "None", "Sleep", "Shutdown", "LowBattery", "Charge" };
+static const char* const BUTTON_NAMES[] = {
+    "PowerSingle", "PowerDouble", "PowerTriple", "PowerLong", "PowerLongLong",
+    "UserSingle", "UserDouble", "UserTriple", "UserLong", "UserLongLong", "Others"
+};
+
+template <size_t N>
+static const char* _name(const char* const (&names)[N], uint32_t i)
+{
+    return (i < N) ? names[i] : "?";
+}
+
+static uint32_t _le32(const unsigned char* b)
+{
+    return (uint32_t) b[0] | (uint32_t) b[1] << 8 | (uint32_t) b[2] << 16 | (uint32_t) b[3] << 24;
+}
+
+// The arg of a record in words (pbo_trace_event_t tells its encoding)
+static std::string _explain(const pbo_trace_record_t& rec)
+{
+    char buf[64];
+    uint32_t lo = rec.arg & 0xff;
+    uint32_t hi = (rec.arg >> 8) & 0xff;
+    switch (rec.event) {
+        case PboTraceStateChange:
+            snprintf(buf, sizeof(buf), "%s <- %s", _name(STATE_NAMES, lo), _name(STATE_NAMES, hi));
+            break;
+        case PboTraceDeferBegin:
+        case PboTraceDeferCancel:
+        case PboTraceDeferRun:
+        case PboTraceDeferQueue:
+            snprintf(buf, sizeof(buf), "%s", _name(REASON_NAMES, rec.arg));
+            break;
+        case PboTraceDeferPreempt:
+            snprintf(buf, sizeof(buf), "%s preempts %s", _name(REASON_NAMES, lo), _name(REASON_NAMES, hi));
+            break;
+        case PboTraceButton:
+        case PboTraceButtonDropped:
+            snprintf(buf, sizeof(buf), "%s", _name(BUTTON_NAMES, rec.arg));
+            break;
+        case PboTraceAdcSample:
+            snprintf(buf, sizeof(buf), "%u.%03u V", (unsigned) (rec.arg / 1000), (unsigned) (rec.arg % 1000));
+            break;
+        case PboTraceDormantExit:
+            snprintf(buf, sizeof(buf), "%s", (rec.arg == 0) ? "Power switch" : "max_sleep_ms");
+            break;
+        case PboTraceBatteryLevel:
+            snprintf(buf, sizeof(buf), "level %u <- %u", (unsigned) lo, (unsigned) hi);
+            break;
+        default:
+            buf[0] = '\0';
+            break;
+    }
+    return buf;
+}
+
+static int _usage()
+{
+    fprintf(stderr, "usage: pbo_trace_decode [--explain] [-o OUT] FILE|-\n");
+    return 2;
+}
+
+int main(int argc, char** argv)
+{
+    const char* in_path = nullptr;
+    const char* out_path = nullptr;
+    bool explain = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--explain") == 0) {
+            explain = true;
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else if (in_path == nullptr) {
+            in_path = argv[i];
+        } else {
+            return _usage();
+        }
+    }
+    if (in_path == nullptr) {
+        return _usage();
+    }
+    FILE* in = (strcmp(in_path, "-") == 0) ? stdin : fopen(in_path, "rb");
+    if (in == nullptr) {
+        fprintf(stderr, "cannot open %s\n", in_path);
+        return 1;
+    }
+    FILE* out = (out_path == nullptr) ? stdout : fopen(out_path, "w");
+    if (out == nullptr) {
+        fprintf(stderr, "cannot write %s\n", out_path);
+        return 1;
+    }
+
+    unsigned char b[sizeof(pbo_trace_record_t)];
+    uint32_t prev_us = 0;
+    bool first = true;
+    size_t n;
+    while ((n = fread(b, 1, sizeof(b), in)) == sizeof(b)) {
+        pbo_trace_record_t rec = { _le32(b), _le32(b + 4), _le32(b + 8) };
+        // same columns as pbo_trace_dump(); the deltas wrap with time_us_32()
+        uint32_t delta_us = first ? 0 : rec.timestamp_us - prev_us;
+        fprintf(out, "%10lu us (+%8lu) %-14s %lu", (unsigned long) rec.timestamp_us,
+                (unsigned long) delta_us, _name(EVENT_NAMES, rec.event), (unsigned long) rec.arg);
+        if (explain) {
+            std::string what = _explain(rec);
+            if (!what.empty()) {
+                fprintf(out, "  (%s)", what.c_str());
+            }
+        }
+        fputc('\n', out);
+        prev_us = rec.timestamp_us;
+        first = false;
+    }
+    if (n != 0) {
+        fprintf(stderr, "%s: %zu trailing bytes (not a whole record)\n", in_path, n);
+        return 1;
+    }
+    if (out != stdout) {
+        fclose(out);
+    }
+    return 0;
+}
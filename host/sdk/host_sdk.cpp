@@ -0,0 +1,569 @@
+/*------------------------------------------------------/
+/ Copyright (c) 2026, Elehobica
+/ Released under the BSD-2-Clause
+/ refer to https://opensource.org/licenses/BSD-2-Clause
+/------------------------------------------------------*/
+
+// Host stand-in for the Pico SDK (see host_sdk.h).
+
+#include <cstdlib>
+#include <cstring>
+
+#include "host_sdk.h"
+
+// === Virtual time ===
+static uint64_t _time_us = 0;    // system timer
+static uint64_t _aon_us = 0;     // always-on clock
+static repeating_timer_t* _timer = nullptr;
+static uint64_t _timer_due_us = 0;
+
+// === Pins, ADC, clocks ===
+static bool _gpio_out[HOST_NUM_GPIOS];
+static bool _gpio_in[HOST_NUM_GPIOS];
+static bool _gpio_is_out[HOST_NUM_GPIOS];
+static uint32_t _irq_enabled[HOST_NUM_GPIOS];
+static uint32_t _irq_events[HOST_NUM_GPIOS];
+static void (*_irq_handler[HOST_NUM_GPIOS])(void);
+static uint16_t _adc_raw[HOST_NUM_ADC_INPUTS];
+static uint _adc_input = 0;
+static uint32_t _adc_conversions = 0;
+static bool _adc_temp_sensor = false;
+static bool _adc_temp_settled = false;
+static host_clocks_t _clocks;
+static host_dormant_hook_t _dormant_hook = nullptr;
+static uint32_t _dormant_count = 0;
+static bool _aon_running = false;
+
+// === I2C / DMA ===
+typedef struct {
+    host_i2c_target_t target;
+    void* ctx;
+} i2c_target_slot_t;
+static i2c_target_slot_t _i2c_targets[128];
+static uint32_t _i2c_bytes = 0;
+static uint32_t _i2c_transactions = 0;
+static uint32_t _dma_claimed = 0;
+i2c_inst_t host_i2c0, host_i2c1;
+
+pll_hw_t host_pll_usb;
+static powman_hw_t _powman_hw;
+powman_hw_t* powman_hw = &_powman_hw;
+
+void host_reset(void)
+{
+    _time_us = 0;
+    _aon_us = 0;
+    _timer = nullptr;
+    _timer_due_us = 0;
+    for (uint i = 0; i < HOST_NUM_GPIOS; i++) {
+        _gpio_out[i] = false;
+        _gpio_in[i] = true; // pulled up, switches open
+        _gpio_is_out[i] = false;
+        _irq_enabled[i] = 0;
+        _irq_events[i] = 0;
+        _irq_handler[i] = nullptr;
+    }
+    memset(_adc_raw, 0, sizeof(_adc_raw));
+    _adc_input = 0;
+    _adc_conversions = 0;
+    _adc_temp_sensor = false;
+    _adc_temp_settled = false;
+    _clocks.pll_usb_on = true;
+    _clocks.clk_usb_on = true;
+    _clocks.clk_adc_auxsrc = CLOCKS_CLK_ADC_CTRL_AUXSRC_VALUE_CLKSRC_PLL_USB;
+    _clocks.clk_adc_hz = USB_CLK_HZ;
+    _clocks.clk_rtc_auxsrc = CLOCKS_CLK_RTC_CTRL_AUXSRC_VALUE_CLKSRC_PLL_USB;
+    _clocks.clk_rtc_hz = RTC_CLOCK_FREQ_HZ;
+    _clocks.dormant_source = HOST_DORMANT_SOURCE_NONE;
+    _dormant_hook = nullptr;
+    _dormant_count = 0;
+    _aon_running = false;
+    memset(&_powman_hw, 0, sizeof(_powman_hw));
+    memset(_i2c_targets, 0, sizeof(_i2c_targets));
+    _i2c_bytes = 0;
+    _i2c_transactions = 0;
+    _dma_claimed = 0;
+    memset(&host_i2c0, 0, sizeof(host_i2c0));
+    memset(&host_i2c1, 0, sizeof(host_i2c1));
+    host_i2c0.hw.status = I2C_IC_STATUS_TFE_BITS;
+    host_i2c1.hw.status = I2C_IC_STATUS_TFE_BITS;
+}
+
+void host_advance_us(uint64_t us)
+{
+    uint64_t end_us = _time_us + us;
+    while (_timer != nullptr && _timer_due_us <= end_us) {
+        uint64_t step = _timer_due_us - _time_us;
+        _time_us += step;
+        _aon_us += step;
+        repeating_timer_t* t = _timer;
+        _timer_due_us += (uint64_t) (t->delay_us < 0 ? -t->delay_us : t->delay_us);
+        if (!t->callback(t)) {
+            _timer = nullptr;
+        }
+    }
+    _aon_us += end_us - _time_us;
+    _time_us = end_us;
+}
+
+// Fast-forward over a span in which the repeating timer would change nothing: the timer keeps
+// its phase but does not run (see pbo_predict --skip-ms).
+void host_skip_us(uint64_t us)
+{
+    _time_us += us;
+    _aon_us += us;
+    if (_timer != nullptr) {
+        _timer_due_us += us;
+    }
+}
+
+uint64_t host_time_us(void)
+{
+    return _time_us;
+}
+
+uint64_t host_aon_us(void)
+{
+    return _aon_us;
+}
+
+void host_gpio_set_input(uint pin, bool level)
+{
+    if (_gpio_in[pin] == level) {
+        return;
+    }
+    _gpio_in[pin] = level;
+    uint32_t edge = level ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL;
+    if (_irq_enabled[pin] & edge) {
+        _irq_events[pin] |= edge;
+        if (_irq_handler[pin] != nullptr) {
+            _irq_handler[pin]();
+        }
+    }
+}
+
+bool host_gpio_output(uint pin)
+{
+    return _gpio_out[pin];
+}
+
+void host_adc_set(uint input, uint16_t raw)
+{
+    _adc_raw[input] = raw;
+}
+
+uint32_t host_adc_conversions(void)
+{
+    return _adc_conversions;
+}
+
+bool host_adc_temp_sensor_enabled(void)
+{
+    return _adc_temp_sensor;
+}
+
+void host_set_dormant_hook(host_dormant_hook_t hook)
+{
+    _dormant_hook = hook;
+}
+
+uint32_t host_dormant_count(void)
+{
+    return _dormant_count;
+}
+
+const host_clocks_t* host_clocks(void)
+{
+    return &_clocks;
+}
+
+// Dormant: only the always-on clock runs; the hook decides when the wake comes.
+static void _go_dormant(uint pin, uint64_t alarm_us)
+{
+    _dormant_count++;
+    uint64_t us = (_dormant_hook != nullptr) ? _dormant_hook(pin, alarm_us) : 0;
+    _aon_us += us;
+}
+
+// === pico/time ===
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void* user_data, repeating_timer_t* out)
+{
+    out->delay_us = delay_us;
+    out->callback = callback;
+    out->user_data = user_data;
+    _timer = out;
+    _timer_due_us = _time_us + (uint64_t) (delay_us < 0 ? -delay_us : delay_us);
+    return true;
+}
+
+bool cancel_repeating_timer(repeating_timer_t* timer)
+{
+    if (_timer != timer) {
+        return false;
+    }
+    _timer = nullptr;
+    return true;
+}
+
+absolute_time_t get_absolute_time(void) { return _time_us; }
+absolute_time_t make_timeout_time_ms(uint32_t ms) { return _time_us + (uint64_t) ms * 1000; }
+absolute_time_t delayed_by_ms(absolute_time_t t, uint32_t ms) { return t + (uint64_t) ms * 1000; }
+absolute_time_t delayed_by_us(absolute_time_t t, uint64_t us) { return t + us; }
+int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to) { return (int64_t) (to - from); }
+bool time_reached(absolute_time_t t) { return _time_us >= t; }
+bool is_at_the_end_of_time(absolute_time_t t) { return t == at_the_end_of_time; }
+uint32_t to_ms_since_boot(absolute_time_t t) { return (uint32_t) (t / 1000); }
+uint64_t to_us_since_boot(absolute_time_t t) { return t; }
+absolute_time_t from_us_since_boot(uint64_t us) { return us; }
+uint64_t time_us_64(void) { return _time_us; }
+uint32_t time_us_32(void) { return (uint32_t) _time_us; }
+void sleep_ms(uint32_t ms) { host_advance_us((uint64_t) ms * 1000); }
+void sleep_us(uint64_t us) { host_advance_us(us); }
+void tight_loop_contents(void) {}
+void __wfi(void) { abort(); } // only reached after a deep-Sleep power-down request succeeded
+
+void sleep_until(absolute_time_t t)
+{
+    if (t > _time_us) {
+        host_advance_us(t - _time_us);
+    }
+}
+
+bool best_effort_wfe_or_timeout(absolute_time_t t)
+{
+    sleep_until(t);
+    return true;
+}
+
+// === hardware/gpio ===
+void gpio_init(uint gpio) { _gpio_is_out[gpio] = false; _gpio_out[gpio] = false; }
+void gpio_put(uint gpio, bool value) { _gpio_out[gpio] = value; }
+bool gpio_get(uint gpio) { return _gpio_is_out[gpio] ? _gpio_out[gpio] : _gpio_in[gpio]; }
+void gpio_set_dir(uint gpio, bool out) { _gpio_is_out[gpio] = out; }
+void gpio_pull_up(uint gpio) { (void) gpio; }
+void gpio_pull_down(uint gpio) { (void) gpio; }
+void gpio_disable_pulls(uint gpio) { (void) gpio; }
+void gpio_set_input_enabled(uint gpio, bool enabled) { (void) gpio; (void) enabled; }
+void gpio_set_oeover(uint gpio, uint value) { (void) gpio; (void) value; }
+void gpio_set_function(uint gpio, uint fn) { (void) gpio; (void) fn; }
+void gpio_add_raw_irq_handler(uint gpio, void (*handler)(void)) { _irq_handler[gpio] = handler; }
+void gpio_acknowledge_irq(uint gpio, uint32_t events) { _irq_events[gpio] &= ~events; }
+uint32_t gpio_get_irq_event_mask(uint gpio) { return _irq_events[gpio]; }
+void gpio_set_dormant_irq_enabled(uint gpio, uint32_t events, bool enabled) { (void) gpio; (void) events; (void) enabled; }
+void irq_set_enabled(uint num, bool enabled) { (void) num; (void) enabled; }
+
+void gpio_set_irq_enabled(uint gpio, uint32_t events, bool enabled)
+{
+    if (enabled) {
+        _irq_enabled[gpio] |= events;
+    } else {
+        _irq_enabled[gpio] &= ~events;
+    }
+}
+
+// === hardware/sync ===
+uint32_t save_and_disable_interrupts(void) { return 0; }
+void restore_interrupts(uint32_t status) { (void) status; }
+
+// === hardware/adc ===
+void adc_init(void) {}
+void adc_gpio_init(uint gpio) { (void) gpio; }
+void adc_select_input(uint input) { _adc_input = input; }
+void adc_set_temp_sensor_enabled(bool enable)
+{
+    if (enable && !_adc_temp_sensor) {
+        _adc_temp_settled = false;
+    }
+    _adc_temp_sensor = enable;
+}
+
+uint16_t adc_read(void)
+{
+    _adc_conversions++;
+    if (_adc_input == ADC_TEMPERATURE_CHANNEL_NUM && !_adc_temp_sensor) {
+        return 0; // bias off: the sensor reads as ground
+    }
+    if (_adc_input == ADC_TEMPERATURE_CHANNEL_NUM && !_adc_temp_settled) {
+        _adc_temp_settled = true;
+        return _adc_raw[_adc_input] / 2; // first conversion after enabling: bias still settling
+    }
+    return _adc_raw[_adc_input];
+}
+
+// === hardware/clocks, hardware/pll ===
+bool clock_configure(enum clock_index clk_index, uint32_t src, uint32_t auxsrc, uint32_t src_freq, uint32_t freq)
+{
+    (void) src;
+    (void) src_freq;
+    switch (clk_index) {
+        case clk_usb:
+            _clocks.clk_usb_on = _clocks.pll_usb_on;
+            break;
+        case clk_adc:
+            _clocks.clk_adc_auxsrc = auxsrc;
+            _clocks.clk_adc_hz = freq;
+            break;
+        case clk_rtc:
+            _clocks.clk_rtc_auxsrc = auxsrc;
+            _clocks.clk_rtc_hz = freq;
+            break;
+        default:
+            break;
+    }
+    return true;
+}
+
+void clock_stop(enum clock_index clk_index)
+{
+    if (clk_index == clk_usb) {
+        _clocks.clk_usb_on = false;
+    }
+}
+
+uint32_t clock_get_hz(enum clock_index clk_index)
+{
+    switch (clk_index) {
+        case clk_adc: return _clocks.clk_adc_hz;
+        case clk_rtc: return _clocks.clk_rtc_hz;
+        case clk_usb: return _clocks.clk_usb_on ? USB_CLK_HZ : 0;
+        default: return 125000000u;
+    }
+}
+
+void pll_init(PLL pll, uint ref_div, uint vco_freq, uint post_div1, uint post_div2)
+{
+    (void) pll; (void) ref_div; (void) vco_freq; (void) post_div1; (void) post_div2;
+    _clocks.pll_usb_on = true;
+}
+
+void pll_deinit(PLL pll)
+{
+    (void) pll;
+    _clocks.pll_usb_on = false;
+}
+
+// === hardware/watchdog, pico/stdio ===
+void watchdog_reboot(uint32_t pc, uint32_t sp, uint32_t delay_ms) { (void) pc; (void) sp; (void) delay_ms; }
+bool watchdog_caused_reboot(void) { return false; }
+bool stdio_uart_init(void) { return true; }
+bool stdio_uart_deinit(void) { return true; }
+bool stdio_usb_init(void) { return true; }
+bool stdio_usb_deinit(void) { return true; }
+void stdio_flush(void) {}
+
+// === pico/util/queue ===
+void queue_init(queue_t* q, uint element_size, uint element_count)
+{
+    free(q->data);
+    q->data = (uint8_t*) calloc(element_count, element_size);
+    q->element_size = element_size;
+    q->element_count = element_count;
+    q->rptr = 0;
+    q->level = 0;
+}
+
+bool queue_try_add(queue_t* q, const void* data)
+{
+    if (q->level == q->element_count) {
+        return false;
+    }
+    uint wptr = (q->rptr + q->level) % q->element_count;
+    memcpy(q->data + wptr * q->element_size, data, q->element_size);
+    q->level++;
+    return true;
+}
+
+bool queue_try_remove(queue_t* q, void* data)
+{
+    if (q->level == 0) {
+        return false;
+    }
+    memcpy(data, q->data + q->rptr * q->element_size, q->element_size);
+    q->rptr = (q->rptr + 1) % q->element_count;
+    q->level--;
+    return true;
+}
+
+void queue_remove_blocking(queue_t* q, void* data)
+{
+    if (!queue_try_remove(q, data)) {
+        abort(); // would block forever: nothing else runs on the host
+    }
+}
+
+uint queue_get_level(queue_t* q)
+{
+    return q->level;
+}
+
+// === pico/sleep ===
+void sleep_run_from_xosc(void) { _clocks.dormant_source = HOST_DORMANT_SOURCE_XOSC; }
+void sleep_run_from_lposc(void) { _clocks.dormant_source = HOST_DORMANT_SOURCE_LPOSC; }
+void sleep_power_up(void) { _clocks.dormant_source = HOST_DORMANT_SOURCE_NONE; }
+
+void sleep_goto_dormant_until_pin(uint gpio_pin, bool edge, bool high)
+{
+    (void) edge;
+    (void) high;
+    _go_dormant(gpio_pin, UINT64_MAX);
+}
+
+void sleep_goto_dormant_until(struct timespec* ts, aon_timer_alarm_handler_t callback)
+{
+    uint64_t alarm_us = (uint64_t) ts->tv_sec * 1000000 + (uint64_t) ts->tv_nsec / 1000;
+    _go_dormant(UINT32_MAX, alarm_us);
+    if (_aon_us >= alarm_us && callback != nullptr) {
+        callback();
+    }
+}
+
+// === pico/aon_timer ===
+bool aon_timer_start(const struct timespec* ts)
+{
+    _aon_us = (uint64_t) ts->tv_sec * 1000000 + (uint64_t) ts->tv_nsec / 1000;
+    _aon_running = true;
+    return true;
+}
+
+bool aon_timer_is_running(void)
+{
+    return _aon_running;
+}
+
+bool aon_timer_get_time(struct timespec* ts)
+{
+    ts->tv_sec = (time_t) (_aon_us / 1000000);
+    ts->tv_nsec = (long) (_aon_us % 1000000) * 1000;
+    return true;
+}
+
+void aon_timer_disable_alarm(void) {}
+
+// === hardware/powman (deep Sleep is never entered on the host) ===
+powman_power_state powman_power_state_with_domain_on(powman_power_state orig, enum powman_power_domains domain)
+{
+    return orig | (1u << domain);
+}
+
+bool powman_configure_wakeup_state(powman_power_state sleep_state, powman_power_state wakeup_state)
+{
+    (void) sleep_state;
+    (void) wakeup_state;
+    return false; // the library falls back to dormant
+}
+
+void powman_set_debug_power_request_ignored(bool ignored) { (void) ignored; }
+void powman_enable_gpio_wakeup(uint gpio_wakeup_num, uint32_t gpio, bool edge, bool high) { (void) gpio_wakeup_num; (void) gpio; (void) edge; (void) high; }
+void powman_disable_gpio_wakeup(uint gpio_wakeup_num) { (void) gpio_wakeup_num; }
+void powman_enable_alarm_wakeup_at_ms(uint64_t alarm_time_ms) { (void) alarm_time_ms; }
+void powman_disable_alarm_wakeup(void) {}
+int powman_set_power_state(powman_power_state state) { (void) state; return PICO_ERROR_GENERIC; }
+uint64_t powman_timer_get_ms(void) { return _aon_us / 1000; }
+
+// === hardware/i2c ===
+void host_i2c_attach(uint8_t addr, host_i2c_target_t target, void* ctx)
+{
+    _i2c_targets[addr & 0x7f].target = target;
+    _i2c_targets[addr & 0x7f].ctx = ctx;
+}
+
+uint32_t host_i2c_bytes(void)
+{
+    return _i2c_bytes;
+}
+
+uint32_t host_i2c_transactions(void)
+{
+    return _i2c_transactions;
+}
+
+static int _i2c_deliver(uint8_t addr, const uint8_t* src, size_t len)
+{
+    const i2c_target_slot_t* slot = &_i2c_targets[addr & 0x7f];
+    if (slot->target == nullptr) {
+        return PICO_ERROR_GENERIC;
+    }
+    slot->target(slot->ctx, src, len);
+    _i2c_bytes += (uint32_t) len;
+    _i2c_transactions++;
+    return (int) len;
+}
+
+uint i2c_init(i2c_inst_t* i2c, uint baudrate)
+{
+    i2c->hw.enable = 1;
+    return baudrate;
+}
+
+void i2c_deinit(i2c_inst_t* i2c)
+{
+    i2c->hw.enable = 0;
+}
+
+int i2c_write_blocking(i2c_inst_t* i2c, uint8_t addr, const uint8_t* src, size_t len, bool nostop)
+{
+    (void) i2c;
+    (void) nostop;
+    return _i2c_deliver(addr, src, len);
+}
+
+i2c_hw_t* i2c_get_hw(i2c_inst_t* i2c)
+{
+    return &i2c->hw;
+}
+
+uint i2c_get_dreq(i2c_inst_t* i2c, bool is_tx)
+{
+    return (i2c == i2c1 ? 34 : 32) + (is_tx ? 0 : 1);
+}
+
+// === hardware/dma ===
+int dma_claim_unused_channel(bool required)
+{
+    for (int ch = 0; ch < 12; ch++) {
+        if (!(_dma_claimed & (1u << ch))) {
+            _dma_claimed |= 1u << ch;
+            return ch;
+        }
+    }
+    if (required) {
+        abort();
+    }
+    return -1;
+}
+
+void dma_channel_unclaim(uint channel) { _dma_claimed &= ~(1u << channel); }
+dma_channel_config dma_channel_get_default_config(uint channel) { (void) channel; dma_channel_config c = { 0 }; return c; }
+void channel_config_set_transfer_data_size(dma_channel_config* c, enum dma_channel_transfer_size size) { c->ctrl = (c->ctrl & ~3u) | (uint32_t) size; }
+void channel_config_set_read_increment(dma_channel_config* c, bool incr) { (void) c; (void) incr; }
+void channel_config_set_write_increment(dma_channel_config* c, bool incr) { (void) c; (void) incr; }
+void channel_config_set_dreq(dma_channel_config* c, uint dreq) { (void) c; (void) dreq; }
+bool dma_channel_is_busy(uint channel) { (void) channel; return false; }
+void dma_channel_abort(uint channel) { (void) channel; }
+
+// A 16-bit stream into IC_DATA_CMD: the low byte is data, STOP ends the transaction to IC_TAR.
+// Other transfers are not modelled.
+void dma_channel_configure(uint channel, const dma_channel_config* config, volatile void* write_addr,
+                           const volatile void* read_addr, uint transfer_count, bool trigger)
+{
+    (void) channel;
+    i2c_hw_t* hw = nullptr;
+    if (write_addr == &host_i2c0.hw.data_cmd) {
+        hw = &host_i2c0.hw;
+    } else if (write_addr == &host_i2c1.hw.data_cmd) {
+        hw = &host_i2c1.hw;
+    }
+    if (!trigger || hw == nullptr || (config->ctrl & 3u) != DMA_SIZE_16) {
+        return;
+    }
+    const volatile uint16_t* words = (const volatile uint16_t*) read_addr;
+    uint8_t txn[4096];
+    size_t len = 0;
+    for (uint i = 0; i < transfer_count; i++) {
+        txn[len++] = (uint8_t) words[i];
+        if ((words[i] & I2C_IC_DATA_CMD_STOP_BITS) || len == sizeof(txn) || i == transfer_count - 1) {
+            _i2c_deliver((uint8_t) hw->tar, txn, len);
+            len = 0;
+        }
+    }
+}
@@ -0,0 +1,283 @@
+/*------------------------------------------------------/
+/ Copyright (c) 2026, Elehobica
+/ Released under the BSD-2-Clause
+/ refer to https://opensource.org/licenses/BSD-2-Clause
+/------------------------------------------------------*/
+
+// Host (Linux / macOS) stand-in for the parts of the Pico SDK and pico-extras used by
+// pico_battery_op.cpp and pico-ssd1306. The SDK header names under host/sdk/ all include this
+// file. Time is virtual: it only moves through host_advance_us() and the dormant hook, so a
+// simulated day runs in milliseconds and every run is reproducible.
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef unsigned int uint;
+
+// === Host controls (not part of the SDK) ===
+#define HOST_NUM_GPIOS 48
+#define HOST_NUM_ADC_INPUTS 9
+
+// Called when the library goes dormant. pin is the wake pin (falling edge), alarm_us the
+// always-on time of the wake alarm (UINT64_MAX = none). Return the dormant duration [us];
+// the always-on clock advances by it, the system timer does not.
+typedef uint64_t (*host_dormant_hook_t)(uint pin, uint64_t alarm_us);
+
+void host_reset(void);                          // clear all stand-in state (time 0, pins high)
+void host_advance_us(uint64_t us);              // run time forward, firing the repeating timer
+void host_skip_us(uint64_t us);                 // run time forward, moving the timer along unfired
+uint64_t host_time_us(void);                    // system timer (stops while dormant)
+uint64_t host_aon_us(void);                     // always-on clock (AON / POWMAN timer)
+void host_gpio_set_input(uint pin, bool level); // drive an input; raises the GPIO IRQ edges
+bool host_gpio_output(uint pin);                // level last written by gpio_put()
+void host_adc_set(uint input, uint16_t raw);    // raw code returned by adc_read() for input
+uint32_t host_adc_conversions(void);            // adc_read() calls since host_reset()
+bool host_adc_temp_sensor_enabled(void);
+void host_set_dormant_hook(host_dormant_hook_t hook);
+uint32_t host_dormant_count(void);
+
+// I2C target model: receives each write transaction (START .. STOP) addressed to it, whether
+// written with i2c_write_blocking() or paced into IC_DATA_CMD by DMA. Writes to an address
+// without a target are not acknowledged (PICO_ERROR_GENERIC).
+typedef void (*host_i2c_target_t)(void* ctx, const uint8_t* src, size_t len);
+void host_i2c_attach(uint8_t addr, host_i2c_target_t target, void* ctx);
+uint32_t host_i2c_bytes(void);                  // bytes written since host_reset() (address excluded)
+uint32_t host_i2c_transactions(void);           // write transactions since host_reset()
+
+// Clock tree state for the clock-gating code
+typedef struct _host_clocks_t {
+    bool pll_usb_on;
+    bool clk_usb_on;
+    uint32_t clk_adc_auxsrc;
+    uint32_t clk_adc_hz;
+    uint32_t clk_rtc_auxsrc;
+    uint32_t clk_rtc_hz;
+    uint32_t dormant_source;    // HOST_DORMANT_SOURCE_* last selected with sleep_run_from_*()
+} host_clocks_t;
+#define HOST_DORMANT_SOURCE_NONE  0
+#define HOST_DORMANT_SOURCE_XOSC  1
+#define HOST_DORMANT_SOURCE_LPOSC 2
+const host_clocks_t* host_clocks(void);
+
+// === pico/types, pico/time ===
+typedef uint64_t absolute_time_t;
+typedef struct repeating_timer repeating_timer_t;
+typedef bool (*repeating_timer_callback_t)(repeating_timer_t* rt);
+struct repeating_timer {
+    int64_t delay_us;
+    repeating_timer_callback_t callback;
+    void* user_data;
+};
+#define at_the_end_of_time ((absolute_time_t) UINT64_MAX)
+#define nil_time ((absolute_time_t) 0)
+
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void* user_data, repeating_timer_t* out);
+bool cancel_repeating_timer(repeating_timer_t* timer);
+absolute_time_t get_absolute_time(void);
+absolute_time_t make_timeout_time_ms(uint32_t ms);
+absolute_time_t delayed_by_ms(absolute_time_t t, uint32_t ms);
+absolute_time_t delayed_by_us(absolute_time_t t, uint64_t us);
+int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to);
+bool time_reached(absolute_time_t t);
+bool is_at_the_end_of_time(absolute_time_t t);
+uint32_t to_ms_since_boot(absolute_time_t t);
+uint64_t to_us_since_boot(absolute_time_t t);
+absolute_time_t from_us_since_boot(uint64_t us);
+bool best_effort_wfe_or_timeout(absolute_time_t t);
+uint64_t time_us_64(void);
+uint32_t time_us_32(void);
+void sleep_ms(uint32_t ms);
+void sleep_us(uint64_t us);
+void sleep_until(absolute_time_t t);
+void tight_loop_contents(void);
+void __wfi(void);
+
+#define PICO_OK 0
+#define PICO_ERROR_GENERIC -1
+#define PICO_ERROR_TIMEOUT -2
+#define __not_in_flash_func(x) x
+#define __time_critical_func(x) x
+#define PICO_DEFAULT_LED_PIN 25
+
+// === hardware/gpio ===
+#define GPIO_IN  false
+#define GPIO_OUT true
+#define GPIO_FUNC_I2C 3
+#define GPIO_FUNC_SIO 5
+#define GPIO_IRQ_LEVEL_LOW  0x1u
+#define GPIO_IRQ_LEVEL_HIGH 0x2u
+#define GPIO_IRQ_EDGE_FALL  0x4u
+#define GPIO_IRQ_EDGE_RISE  0x8u
+#define NUM_BANK0_GPIOS 30
+#define IO_IRQ_BANK0 13
+#define IO_BANK0_GPIO0_CTRL_OEOVER_VALUE_DISABLE 2
+
+void gpio_init(uint gpio);
+void gpio_put(uint gpio, bool value);
+bool gpio_get(uint gpio);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_pull_up(uint gpio);
+void gpio_pull_down(uint gpio);
+void gpio_disable_pulls(uint gpio);
+void gpio_set_input_enabled(uint gpio, bool enabled);
+void gpio_set_oeover(uint gpio, uint value);
+void gpio_set_function(uint gpio, uint fn);
+void gpio_set_irq_enabled(uint gpio, uint32_t events, bool enabled);
+void gpio_add_raw_irq_handler(uint gpio, void (*handler)(void));
+void gpio_acknowledge_irq(uint gpio, uint32_t events);
+uint32_t gpio_get_irq_event_mask(uint gpio);
+void gpio_set_dormant_irq_enabled(uint gpio, uint32_t events, bool enabled);
+void irq_set_enabled(uint num, bool enabled);
+
+// === hardware/sync ===
+uint32_t save_and_disable_interrupts(void);
+void restore_interrupts(uint32_t status);
+
+// === hardware/adc ===
+#define ADC_TEMPERATURE_CHANNEL_NUM 4
+void adc_init(void);
+void adc_gpio_init(uint gpio);
+void adc_select_input(uint input);
+uint16_t adc_read(void);
+void adc_set_temp_sensor_enabled(bool enable);
+
+// === hardware/clocks, hardware/pll ===
+enum clock_index { clk_gpout0 = 0, clk_gpout1, clk_gpout2, clk_gpout3, clk_ref, clk_sys, clk_peri,
+                   clk_hstx, clk_usb, clk_adc, clk_rtc, CLK_COUNT };
+#define CLOCKS_CLK_ADC_CTRL_AUXSRC_VALUE_CLKSRC_PLL_USB 0x0
+#define CLOCKS_CLK_ADC_CTRL_AUXSRC_VALUE_XOSC_CLKSRC    0x3
+#define CLOCKS_CLK_USB_CTRL_AUXSRC_VALUE_CLKSRC_PLL_USB 0x0
+#define CLOCKS_CLK_RTC_CTRL_AUXSRC_VALUE_CLKSRC_PLL_USB 0x0
+#define CLOCKS_CLK_RTC_CTRL_AUXSRC_VALUE_XOSC_CLKSRC    0x3
+#define USB_CLK_HZ 48000000u
+#define XOSC_HZ    12000000u
+#define RTC_CLOCK_FREQ_HZ (USB_CLK_HZ / 1024)
+bool clock_configure(enum clock_index clk_index, uint32_t src, uint32_t auxsrc, uint32_t src_freq, uint32_t freq);
+void clock_stop(enum clock_index clk_index);
+uint32_t clock_get_hz(enum clock_index clk_index);
+
+typedef struct { int unused; } pll_hw_t;
+typedef pll_hw_t* PLL;
+extern pll_hw_t host_pll_usb;
+#define pll_usb (&host_pll_usb)
+#define PLL_USB_REFDIV 1
+#define PLL_USB_VCO_FREQ_HZ 1200000000u
+#define PLL_USB_POSTDIV1 5
+#define PLL_USB_POSTDIV2 5
+void pll_init(PLL pll, uint ref_div, uint vco_freq, uint post_div1, uint post_div2);
+void pll_deinit(PLL pll);
+
+// === hardware/watchdog ===
+void watchdog_reboot(uint32_t pc, uint32_t sp, uint32_t delay_ms);
+bool watchdog_caused_reboot(void);
+
+// === pico/stdio ===
+bool stdio_uart_init(void);
+bool stdio_uart_deinit(void);
+bool stdio_usb_init(void);
+bool stdio_usb_deinit(void);
+void stdio_flush(void);
+
+// === pico/util/queue ===
+typedef struct {
+    uint8_t* data;
+    uint element_size;
+    uint element_count;
+    uint rptr;
+    uint level;
+} queue_t;
+void queue_init(queue_t* q, uint element_size, uint element_count);
+bool queue_try_add(queue_t* q, const void* data);
+bool queue_try_remove(queue_t* q, void* data);
+void queue_remove_blocking(queue_t* q, void* data);
+uint queue_get_level(queue_t* q);
+
+// === pico/sleep (pico-extras) ===
+typedef void (*aon_timer_alarm_handler_t)(void);
+void sleep_run_from_xosc(void);
+void sleep_run_from_lposc(void);
+void sleep_goto_dormant_until_pin(uint gpio_pin, bool edge, bool high);
+void sleep_goto_dormant_until(struct timespec* ts, aon_timer_alarm_handler_t callback);
+void sleep_power_up(void);
+
+// === pico/aon_timer ===
+bool aon_timer_start(const struct timespec* ts);
+bool aon_timer_is_running(void);
+bool aon_timer_get_time(struct timespec* ts);
+void aon_timer_disable_alarm(void);
+
+// === hardware/powman ===
+typedef uint32_t powman_power_state;
+enum powman_power_domains {
+    POWMAN_POWER_DOMAIN_SRAM_BANK1 = 0,
+    POWMAN_POWER_DOMAIN_SRAM_BANK0,
+    POWMAN_POWER_DOMAIN_XIP_CACHE,
+    POWMAN_POWER_DOMAIN_SWITCHED_CORE
+};
+#define POWMAN_POWER_STATE_NONE 0
+#define POWMAN_CHIP_RESET_HAD_SWCORE_PD_BITS (1u << 27)
+typedef struct {
+    volatile uint32_t scratch[8];
+    volatile uint32_t boot[4];
+    volatile uint32_t chip_reset;
+} powman_hw_t;
+extern powman_hw_t* powman_hw;
+powman_power_state powman_power_state_with_domain_on(powman_power_state orig, enum powman_power_domains domain);
+bool powman_configure_wakeup_state(powman_power_state sleep_state, powman_power_state wakeup_state);
+void powman_set_debug_power_request_ignored(bool ignored);
+void powman_enable_gpio_wakeup(uint gpio_wakeup_num, uint32_t gpio, bool edge, bool high);
+void powman_disable_gpio_wakeup(uint gpio_wakeup_num);
+void powman_enable_alarm_wakeup_at_ms(uint64_t alarm_time_ms);
+void powman_disable_alarm_wakeup(void);
+int powman_set_power_state(powman_power_state state);
+uint64_t powman_timer_get_ms(void);
+
+// === hardware/i2c ===
+typedef struct _i2c_hw_t {
+    volatile uint32_t con, tar, data_cmd, enable, status, clr_tx_abrt;
+} i2c_hw_t;
+typedef struct _i2c_inst_t {
+    i2c_hw_t hw;
+} i2c_inst_t;
+extern i2c_inst_t host_i2c0, host_i2c1;
+#define i2c0 (&host_i2c0)
+#define i2c1 (&host_i2c1)
+#define I2C_IC_DATA_CMD_STOP_BITS       0x200u
+#define I2C_IC_ENABLE_ABORT_BITS        0x2u
+#define I2C_IC_STATUS_TFE_BITS          0x4u
+#define I2C_IC_STATUS_MST_ACTIVITY_BITS 0x20u
+uint i2c_init(i2c_inst_t* i2c, uint baudrate);
+void i2c_deinit(i2c_inst_t* i2c);
+int i2c_write_blocking(i2c_inst_t* i2c, uint8_t addr, const uint8_t* src, size_t len, bool nostop);
+i2c_hw_t* i2c_get_hw(i2c_inst_t* i2c);
+uint i2c_get_dreq(i2c_inst_t* i2c, bool is_tx);
+
+// === hardware/dma ===
+// Transfers complete when started: a channel writing IC_DATA_CMD feeds the I2C target model.
+typedef struct _dma_channel_config {
+    uint32_t ctrl;
+} dma_channel_config;
+enum dma_channel_transfer_size { DMA_SIZE_8 = 0, DMA_SIZE_16 = 1, DMA_SIZE_32 = 2 };
+int dma_claim_unused_channel(bool required);
+void dma_channel_unclaim(uint channel);
+dma_channel_config dma_channel_get_default_config(uint channel);
+void channel_config_set_transfer_data_size(dma_channel_config* c, enum dma_channel_transfer_size size);
+void channel_config_set_read_increment(dma_channel_config* c, bool incr);
+void channel_config_set_write_increment(dma_channel_config* c, bool incr);
+void channel_config_set_dreq(dma_channel_config* c, uint dreq);
+void dma_channel_configure(uint channel, const dma_channel_config* config, volatile void* write_addr,
+                           const volatile void* read_addr, uint transfer_count, bool trigger);
+bool dma_channel_is_busy(uint channel);
+void dma_channel_abort(uint channel);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,515 @@
+/*------------------------------------------------------/
+/ Copyright (c) 2026, Elehobica
+/ Released under the BSD-2-Clause
+/ refer to https://opensource.org/licenses/BSD-2-Clause
+/------------------------------------------------------*/
+
+// Off-target benchmark of pico-ssd1306: renders the battery_op_with_ssd1306 screens (view.cpp)
+// through the I2C / DMA stand-in into the SSD1306 controller model, checks after every frame
+// that the simulated GDDRAM matches the framebuffer, and reports the bus traffic per frame of
+// ssd1306_show(), ssd1306_show_async() and a full-frame baseline. Then compares known text,
+// line and square drawings bit for bit with golden ssd1306_dump_pbm() images, and times the
+// drawing primitives (see host/README.md).
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "host_sdk.h"
+#include "ssd1306.h"
+#include "ssd1306_model.h"
+#include "view.h"
+
+static const uint8_t DISP_ADDR = 0x3c;
+static const uint32_t LOOP_MS = 10;       // main loop cadence of the timeline
+static const uint32_t I2C_HZ = 400000;
+
+static ssd1306_t disp;
+static uint8_t disp_storage[SSD1306_STATIC_BUFSIZE(128, 64)];
+static ssd1306_model_t panel;
+
+// === Screens =============================================================
+typedef struct {
+    const char* name;
+    uint32_t duration_ms;
+    view_t (*view_at)(uint32_t ms);
+} scenario_t;
+
+static bool _blink(uint32_t ms)
+{
+    return (ms / 500) % 2 == 0; // as the sample: 1 s period, 50% duty
+}
+
+static view_t _status(uint32_t ms)
+{
+    view_t v = {};
+    v.state = PboStateActive;
+    v.sec = 3600 + ms / 1000;
+    v.centivolts = 372 - ms / 15000; // a slowly falling cell
+    v.wakeup_count = 3;
+    return v;
+}
+
+static view_t _usb(uint32_t ms)
+{
+    view_t v = _status(ms);
+    v.usb = true;
+    v.centivolts = 503;
+    return v;
+}
+
+static view_t _announce_sleep(uint32_t ms)
+{
+    view_t v = _status(ms);
+    v.has_deferred = true;
+    v.reason = PboDeferredSleep;
+    v.blink = _blink(ms);
+    return v;
+}
+
+static view_t _low_battery(uint32_t ms)
+{
+    view_t v = _announce_sleep(ms);
+    v.reason = PboDeferredLowBattery;
+    v.centivolts = 289;
+    return v;
+}
+
+static view_t _charging(uint32_t ms)
+{
+    view_t v = {};
+    v.state = PboStateIdle;
+    v.usb = true;
+    v.blink = _blink(ms);
+    return v;
+}
+
+static const scenario_t SCENARIOS[] = {
+    { "status",      60000, _status },          // clock ticking, voltage falling
+    { "usb",         60000, _usb },
+    { "announce",     3000, _announce_sleep },  // deferred Sleep, blinking "GO DORMANT"
+    { "low_battery",  3000, _low_battery },
+    { "charging",    10000, _charging },        // Idle with USB, blinking "Charging"
+};
+
+// === Measurement =========================================================
+typedef enum {
+    ShowSync = 0,  // ssd1306_show(): changed spans only
+    ShowAsync,     // ssd1306_show_async() + ssd1306_wait()
+    ShowFull,      // the whole frame every time (GDDRAM treated as unknown)
+    NUM_SHOW_MODES
+} show_mode_t;
+
+static const char* const SHOW_NAMES[NUM_SHOW_MODES] = { "show", "show_async", "full" };
+
+typedef struct {
+    uint32_t frames;
+    uint32_t bytes;
+    uint32_t xfers;
+    uint32_t max_bytes;
+    double bus_us;
+    double host_us;
+} stats_t;
+
+// Bus time of the transactions sent since *bytes / *xfers: START, address, 9 bits per byte, STOP
+static double _bus_us(uint32_t bytes, uint32_t xfers)
+{
+    return ((double) (bytes + xfers) * 9.0 + 2.0 * xfers) * 1e6 / I2C_HZ;
+}
+
+static bool _check_gddram(const char* what, uint32_t ms)
+{
+    for (uint32_t page = 0; page < disp.pages; page++) {
+        if (memcmp(panel.gddram[page], disp.buffer + page * disp.width, disp.width) != 0) {
+            fprintf(stderr, "%s at %u ms: GDDRAM page %u differs from the framebuffer\n", what, ms, page);
+            return false;
+        }
+    }
+    if (panel.errors != 0) {
+        fprintf(stderr, "%s at %u ms: malformed control byte\n", what, ms);
+        return false;
+    }
+    return true;
+}
+
+static void _display_up()
+{
+    host_reset();
+    ssd1306_model_reset(&panel);
+    host_i2c_attach(DISP_ADDR, ssd1306_model_write, &panel);
+    memset(&disp, 0, sizeof(disp));
+    disp.external_vcc = false;
+    ssd1306_init_static(&disp, 128, 64, DISP_ADDR, i2c0, disp_storage);
+    ssd1306_poweron(&disp);
+    ssd1306_clear(&disp);
+}
+
+static void _show(show_mode_t mode)
+{
+    if (mode == ShowFull) {
+        disp.shadow_valid = false;
+    }
+    if (mode == ShowAsync) {
+        ssd1306_show_async(&disp);
+        ssd1306_wait(&disp);
+    } else {
+        ssd1306_show(&disp);
+    }
+}
+
+// Play the scenario timeline as the sample's main loop does: redraw and show only when the view
+// changed. The first frame (the screen coming up) is not counted.
+static bool _run(const scenario_t* sc, show_mode_t mode, bool check, stats_t* st)
+{
+    view_t shown = sc->view_at(0);
+    draw_view(&disp, shown);
+    _show(mode);
+    for (uint32_t ms = LOOP_MS; ms < sc->duration_ms; ms += LOOP_MS) {
+        view_t v = sc->view_at(ms);
+        if (view_equal(v, shown)) {
+            continue;
+        }
+        uint32_t bytes = host_i2c_bytes();
+        uint32_t xfers = host_i2c_transactions();
+        draw_view(&disp, v);
+        _show(mode);
+        shown = v;
+        bytes = host_i2c_bytes() - bytes;
+        xfers = host_i2c_transactions() - xfers;
+        st->frames++;
+        st->bytes += bytes;
+        st->xfers += xfers;
+        st->bus_us += _bus_us(bytes, xfers);
+        if (bytes > st->max_bytes) {
+            st->max_bytes = bytes;
+        }
+        if (check && !_check_gddram(sc->name, ms)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool _write_pbm(const std::string& dir, const char* name)
+{
+    std::string path = dir + "/" + name + ".pbm";
+    FILE* fp = fopen(path.c_str(), "w");
+    if (fp == nullptr) {
+        fprintf(stderr, "cannot write %s\n", path.c_str());
+        return false;
+    }
+    ssd1306_model_write_pbm(&panel, disp.width, disp.height, fp);
+    fclose(fp);
+    return true;
+}
+
+// === Golden images =======================================================
+// Known drawings covering the glyph fast paths (page-aligned, shifted across two pages, scaled,
+// clipped at the edges), the Bresenham octants and the page masks of ssd1306_draw_square()
+typedef struct {
+    const char* name;
+    void (*draw)(ssd1306_t* p);
+} drawing_t;
+
+static void _text(ssd1306_t* p, uint32_t x, uint32_t y, uint32_t scale, const char* s)
+{
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%s", s);
+    ssd1306_draw_string(p, x, y, scale, buf);
+}
+
+static const char* const CHARSET[] = {
+    " !\"#$%&'()*+,-./0123",
+    "456789:;<=>?@ABCDEFG",
+    "HIJKLMNOPQRSTUVWXYZ[",
+    "\\]^_`abcdefghijklmno",
+    "pqrstuvwxyz{|}~",
+};
+
+static void _draw_text_aligned(ssd1306_t* p)
+{
+    for (uint32_t i = 0; i < 5; i++) {
+        _text(p, 0, i * 8, 1, CHARSET[i]);
+    }
+    _text(p, 6, 48, 1, "Hello, World!");
+}
+
+static void _draw_text_unaligned(ssd1306_t* p)
+{
+    for (uint32_t i = 0; i < 5; i++) {
+        _text(p, i, 1 + i * 11, 1, CHARSET[i]); // every shift but 0
+    }
+}
+
+static void _draw_text_scaled(ssd1306_t* p)
+{
+    _text(p, 0, 0, 2, "12:34");
+    _text(p, 3, 19, 3, "Ag");
+    _text(p, 64, 21, 4, "%");
+    _text(p, 100, 50, 2, "~");
+}
+
+static void _draw_text_clipped(ssd1306_t* p)
+{
+    _text(p, 110, 0, 1, "WXYZ");
+    _text(p, 0, 60, 1, "bottom");
+    _text(p, 60, 58, 2, "edge");
+    _text(p, 120, 40, 3, "M");
+}
+
+static void _draw_lines(ssd1306_t* p)
+{
+    // a fan from the centre to every 16th point of the border: all eight octants
+    for (int32_t x = 0; x < 128; x += 16) {
+        ssd1306_draw_line(p, 64, 32, x, 0);
+        ssd1306_draw_line(p, 64, 32, 127 - x, 63);
+    }
+    for (int32_t y = 0; y < 64; y += 16) {
+        ssd1306_draw_line(p, 64, 32, 0, 63 - y);
+        ssd1306_draw_line(p, 64, 32, 127, y);
+    }
+    ssd1306_draw_line(p, 2, 2, 2, 40);     // vertical
+    ssd1306_draw_line(p, 125, 60, 100, 60); // horizontal, right to left
+}
+
+static void _draw_squares(ssd1306_t* p)
+{
+    ssd1306_draw_square(p, 0, 0, 8, 8);      // one page
+    ssd1306_draw_square(p, 10, 3, 9, 1);     // a single row
+    ssd1306_draw_square(p, 21, 5, 7, 22);    // across four pages
+    ssd1306_draw_square(p, 30, 8, 16, 16);   // two whole pages
+    ssd1306_draw_square(p, 50, 13, 3, 3);    // inside one page
+    ssd1306_draw_square(p, 120, 50, 20, 20); // clipped right and bottom
+    ssd13606_draw_empty_square(p, 60, 30, 40, 20);
+    ssd13606_draw_empty_square(p, 70, 35, 1, 1);
+}
+
+static const drawing_t DRAWINGS[] = {
+    { "text_aligned",   _draw_text_aligned },
+    { "text_unaligned", _draw_text_unaligned },
+    { "text_scaled",    _draw_text_scaled },
+    { "text_clipped",   _draw_text_clipped },
+    { "lines",          _draw_lines },
+    { "squares",        _draw_squares },
+};
+
+// ssd1306_dump_pbm() output of the framebuffer, taken from stdout
+static bool _dump_pbm(std::string* out)
+{
+    fflush(stdout);
+    FILE* tmp = tmpfile();
+    int saved = dup(fileno(stdout));
+    if (tmp == nullptr || saved < 0) {
+        return false;
+    }
+    dup2(fileno(tmp), fileno(stdout));
+    ssd1306_dump_pbm(&disp);
+    fflush(stdout);
+    dup2(saved, fileno(stdout));
+    close(saved);
+    rewind(tmp);
+    out->clear();
+    char buf[1024];
+    for (size_t n; (n = fread(buf, 1, sizeof(buf), tmp)) > 0;) {
+        out->append(buf, n);
+    }
+    fclose(tmp);
+    return true;
+}
+
+static bool _read_file(const std::string& path, std::string* out)
+{
+    FILE* fp = fopen(path.c_str(), "r");
+    if (fp == nullptr) {
+        return false;
+    }
+    out->clear();
+    char buf[1024];
+    for (size_t n; (n = fread(buf, 1, sizeof(buf), fp)) > 0;) {
+        out->append(buf, n);
+    }
+    fclose(fp);
+    return true;
+}
+
+// Draw each golden drawing on a cleared frame and compare its dump with DIR/<name>.pbm (or
+// write it there with update)
+static bool _check_golden(const char* dir, bool update)
+{
+    bool ok = true;
+    for (const drawing_t& d : DRAWINGS) {
+        _display_up();
+        d.draw(&disp);
+        std::string actual;
+        std::string path = std::string(dir) + "/" + d.name + ".pbm";
+        if (!_dump_pbm(&actual)) {
+            fprintf(stderr, "cannot capture the PBM dump\n");
+            return false;
+        }
+        if (update) {
+            FILE* fp = fopen(path.c_str(), "w");
+            if (fp == nullptr || fwrite(actual.data(), 1, actual.size(), fp) != actual.size()) {
+                fprintf(stderr, "cannot write %s\n", path.c_str());
+                return false;
+            }
+            fclose(fp);
+            continue;
+        }
+        std::string golden;
+        if (!_read_file(path, &golden)) {
+            fprintf(stderr, "cannot read %s\n", path.c_str());
+            ok = false;
+        } else if (actual != golden) {
+            fprintf(stderr, "golden %s: the frame differs from %s\n", d.name, path.c_str());
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+// A write into disp.buffer reaches the panel once ssd1306_mark_dirty() covers it, and only then
+static bool _check_direct_write()
+{
+    _display_up();
+    ssd1306_show(&disp);
+    disp.buffer[2 * disp.width + 40] = 0x5a; // page 2, column 40
+    ssd1306_show(&disp);
+    if (panel.gddram[2][40] != 0) {
+        fprintf(stderr, "direct write: sent without ssd1306_mark_dirty()\n");
+        return false;
+    }
+    ssd1306_mark_dirty(&disp, 40, 17, 40, 17);
+    ssd1306_show(&disp);
+    if (!_check_gddram("direct write", 0)) {
+        return false;
+    }
+    return disp.show_bytes != 0 && disp.show_bytes < disp.width;
+}
+
+// === Drawing primitives ==================================================
+typedef struct {
+    const char* primitive;
+    const char* name;
+    void (*draw)(ssd1306_t* p);
+} primitive_case_t;
+
+static void _string_aligned(ssd1306_t* p) { _text(p, 0, 8, 1, "0123456789ABCDEFGHIJ"); }
+static void _string_unaligned(ssd1306_t* p) { _text(p, 0, 11, 1, "0123456789ABCDEFGHIJ"); }
+static void _string_scale2(ssd1306_t* p) { _text(p, 0, 16, 2, "0123456789"); }
+static void _line_shallow(ssd1306_t* p) { ssd1306_draw_line(p, 0, 0, 127, 20); }
+static void _line_steep(ssd1306_t* p) { ssd1306_draw_line(p, 0, 0, 20, 63); }
+static void _line_vertical(ssd1306_t* p) { ssd1306_draw_line(p, 64, 0, 64, 63); }
+static void _square_aligned(ssd1306_t* p) { ssd1306_draw_square(p, 0, 8, 32, 16); }
+static void _square_unaligned(ssd1306_t* p) { ssd1306_draw_square(p, 5, 3, 40, 21); }
+static void _square_small(ssd1306_t* p) { ssd1306_draw_square(p, 9, 9, 4, 4); }
+
+static const primitive_case_t PRIMITIVES[] = {
+    { "draw_string", "20ch_aligned",   _string_aligned },   // y on a page boundary
+    { "draw_string", "20ch_unaligned", _string_unaligned }, // shifted across two pages
+    { "draw_string", "10ch_scale2",    _string_scale2 },
+    { "draw_line",   "shallow",        _line_shallow },
+    { "draw_line",   "steep",          _line_steep },
+    { "draw_line",   "vertical",       _line_vertical },
+    { "draw_square", "32x16_aligned",  _square_aligned },
+    { "draw_square", "40x21_unaligned", _square_unaligned },
+    { "draw_square", "4x4",            _square_small },
+};
+
+// Host time per call of each primitive, drawn batch times into the same frame
+static void _time_primitives(uint32_t batch)
+{
+    printf("\n%-12s %-16s %10s\n", "primitive", "case", "ns/call");
+    for (const primitive_case_t& c : PRIMITIVES) {
+        _display_up();
+        auto t0 = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < batch; i++) {
+            c.draw(&disp);
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+        printf("%-12s %-16s %10.1f\n", c.primitive, c.name, ns / batch);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const char* pbm_dir = nullptr;
+    const char* golden_dir = nullptr;
+    bool update = false;
+    uint32_t repeat = 20;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--pbm") == 0 && i + 1 < argc) {
+            pbm_dir = argv[++i];
+        } else if (strcmp(argv[i], "--golden") == 0 && i + 1 < argc) {
+            golden_dir = argv[++i];
+        } else if (strcmp(argv[i], "--update") == 0) {
+            update = true;
+        } else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = (uint32_t) strtoul(argv[++i], nullptr, 0);
+        } else {
+            fprintf(stderr, "usage: ssd1306_bench [--pbm DIR] [--golden DIR [--update]] [--repeat N]\n");
+            return 2;
+        }
+    }
+
+    printf("%-12s %-10s %6s %10s %10s %9s %10s %11s\n", "screen", "mode", "frames", "bytes/frm",
+           "xfers/frm", "max_bytes", "bus_us/frm", "host_us/frm");
+    for (const scenario_t& sc : SCENARIOS) {
+        for (int mode = 0; mode < NUM_SHOW_MODES; mode++) {
+            // checked pass for the traffic, then timed passes
+            stats_t st = {};
+            _display_up();
+            if (!_run(&sc, (show_mode_t) mode, true, &st)) {
+                return 1;
+            }
+            if (pbm_dir != nullptr && mode == ShowSync && !_write_pbm(pbm_dir, sc.name)) {
+                return 1;
+            }
+            double us = 0.0;
+            for (uint32_t r = 0; r < repeat; r++) {
+                stats_t timed = {};
+                _display_up();
+                auto t0 = std::chrono::steady_clock::now();
+                _run(&sc, (show_mode_t) mode, false, &timed);
+                us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+            }
+            uint32_t frames = st.frames ? st.frames : 1;
+            st.host_us = (repeat != 0) ? us / repeat / frames : 0.0;
+            printf("%-12s %-10s %6u %10.1f %10.2f %9u %10.0f %11.2f\n", sc.name, SHOW_NAMES[mode], st.frames,
+                   (double) st.bytes / frames, (double) st.xfers / frames, st.max_bytes, st.bus_us / frames,
+                   st.host_us);
+        }
+    }
+
+    // Wake from a Sleep: the panel lost power (GDDRAM cleared), ssd1306_reinit() restores it
+    _display_up();
+    draw_view(&disp, _status(0));
+    ssd1306_show(&disp);
+    ssd1306_poweroff(&disp);
+    ssd1306_model_reset(&panel);
+    uint32_t bytes = host_i2c_bytes();
+    uint32_t xfers = host_i2c_transactions();
+    ssd1306_reinit(&disp);
+    bytes = host_i2c_bytes() - bytes;
+    xfers = host_i2c_transactions() - xfers;
+    if (!_check_gddram("reinit", 0) || !panel.display_on) {
+        return 1;
+    }
+    printf("%-12s %-10s %6u %10u %10u %9u %10.0f %11s\n", "wake", "reinit", 1u, bytes, xfers, bytes,
+           _bus_us(bytes, xfers), "-");
+    if (pbm_dir != nullptr && !_write_pbm(pbm_dir, "wake")) {
+        return 1;
+    }
+
+    if (golden_dir != nullptr && !_check_golden(golden_dir, update)) {
+        return 1;
+    }
+    if (!_check_direct_write()) {
+        return 1;
+    }
+    _time_primitives(repeat * 50);
+    return 0;
+}
@@ -0,0 +1,142 @@
+/*------------------------------------------------------/
+/ Copyright (c) 2026, Elehobica
+/ Released under the BSD-2-Clause
+/ refer to https://opensource.org/licenses/BSD-2-Clause
+/------------------------------------------------------*/
+
+#include <cstring>
+
+#include "ssd1306_model.h"
+
+void ssd1306_model_reset(ssd1306_model_t* m)
+{
+    memset(m, 0, sizeof(*m));
+    m->contrast = 0x7f;
+    m->addr_mode = 2;
+    m->col1 = 127;
+    m->page1 = 7;
+}
+
+// Argument bytes following a command (the SSD1306 datasheet command table)
+static uint8_t _num_args(uint8_t cmd)
+{
+    switch (cmd) {
+        case 0x26: case 0x27:              // horizontal scroll setup
+            return 6;
+        case 0x29: case 0x2A:              // vertical and horizontal scroll setup
+            return 5;
+        case 0x21: case 0x22: case 0xA3:   // column / page window, vertical scroll area
+            return 2;
+        case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3:
+        case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static void _execute(ssd1306_model_t* m)
+{
+    uint8_t c = m->cmd;
+    m->commands++;
+    if (c == 0x20) {
+        m->addr_mode = m->args[0] & 3;
+    } else if (c == 0x21) {
+        m->col0 = m->args[0] & 0x7f;
+        m->col1 = m->args[1] & 0x7f;
+        m->col = m->col0;
+    } else if (c == 0x22) {
+        m->page0 = m->args[0] & 7;
+        m->page1 = m->args[1] & 7;
+        m->page = m->page0;
+    } else if (c == 0x81) {
+        m->contrast = m->args[0];
+    } else if (c == 0xAE || c == 0xAF) {
+        m->display_on = (c == 0xAF);
+    } else if (c == 0xA6 || c == 0xA7) {
+        m->inverted = (c == 0xA7);
+    } else if (m->addr_mode == 2 && c >= 0xB0 && c <= 0xB7) {
+        m->page = c & 7;
+    } else if (m->addr_mode == 2 && c <= 0x0F) {
+        m->col = (m->col & 0xf0) | c;
+    } else if (m->addr_mode == 2 && c >= 0x10 && c <= 0x17) {
+        m->col = (m->col & 0x0f) | ((c & 7) << 4);
+    }
+}
+
+static void _command(ssd1306_model_t* m, uint8_t b)
+{
+    if (m->args_need != 0) {
+        m->args[m->args_got++] = b;
+        if (m->args_got == m->args_need) {
+            m->args_need = 0;
+            _execute(m);
+        }
+        return;
+    }
+    m->cmd = b;
+    m->args_got = 0;
+    m->args_need = _num_args(b);
+    if (m->args_need == 0) {
+        _execute(m);
+    }
+}
+
+static void _data(ssd1306_model_t* m, uint8_t b)
+{
+    m->gddram[m->page & 7][m->col & 0x7f] = b;
+    m->data_bytes++;
+    if (m->addr_mode == 0) {         // horizontal: along the column window, then next page
+        if (++m->col > m->col1) {
+            m->col = m->col0;
+            if (++m->page > m->page1) {
+                m->page = m->page0;
+            }
+        }
+    } else if (m->addr_mode == 1) {  // vertical: down the page window, then next column
+        if (++m->page > m->page1) {
+            m->page = m->page0;
+            if (++m->col > m->col1) {
+                m->col = m->col0;
+            }
+        }
+    } else if (m->col < 127) {       // page: along the page, stopping at the last column
+        m->col++;
+    }
+}
+
+// A transaction is a sequence of control bytes (Co, D/C#, six 0 bits), each followed by one byte
+// (Co = 1) or by the rest of the transaction (Co = 0), as commands (D/C# = 0) or data.
+void ssd1306_model_write(void* ctx, const uint8_t* src, size_t len)
+{
+    ssd1306_model_t* m = (ssd1306_model_t*) ctx;
+    size_t i = 0;
+    while (i < len) {
+        uint8_t control = src[i++];
+        if ((control & 0x3f) != 0) {
+            m->errors++;
+            return;
+        }
+        size_t end = (control & 0x80) ? i + 1 : len;
+        for (; i < end && i < len; i++) {
+            if (control & 0x40) {
+                _data(m, src[i]);
+            } else {
+                _command(m, src[i]);
+            }
+        }
+    }
+}
+
+void ssd1306_model_write_pbm(const ssd1306_model_t* m, uint32_t width, uint32_t height, FILE* fp)
+{
+    fprintf(fp, "P1\n%u %u\n", width, height);
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            fputc((m->gddram[y >> 3][x] >> (y & 7)) & 1 ? '1' : '0', fp);
+            if ((x & 63) == 63 || x == width - 1) {
+                fputc('\n', fp);
+            }
+        }
+    }
+}
@@ -0,0 +1,37 @@
+/*------------------------------------------------------/
+/ Copyright (c) 2026, Elehobica
+/ Released under the BSD-2-Clause
+/ refer to https://opensource.org/licenses/BSD-2-Clause
+/------------------------------------------------------*/
+
+// SSD1306 controller model for the host I2C stand-in: decodes the control bytes, commands and
+// display data of each write transaction into a simulated GDDRAM (128 x 64).
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+
+typedef struct _ssd1306_model_t {
+    uint8_t gddram[8][128];  // [page][column], bit n of a byte is row page * 8 + n
+    bool display_on;         // 0xAF / 0xAE
+    bool inverted;           // 0xA7 / 0xA6
+    uint8_t contrast;        // 0x81
+    uint8_t addr_mode;       // 0x20: 0 horizontal, 1 vertical, 2 page
+    uint8_t col0, col1;      // 0x21 column window
+    uint8_t page0, page1;    // 0x22 page window
+    uint8_t col, page;       // GDDRAM write pointer
+    uint8_t cmd;             // command collecting its arguments
+    uint8_t args[6];
+    uint8_t args_need, args_got;
+    uint32_t commands;       // commands decoded (arguments excluded)
+    uint32_t data_bytes;     // GDDRAM bytes written
+    uint32_t errors;         // malformed control bytes
+} ssd1306_model_t;
+
+// Power-on reset state (GDDRAM cleared).
+void ssd1306_model_reset(ssd1306_model_t* m);
+// host_i2c_target_t: one write transaction addressed to the controller.
+void ssd1306_model_write(void* ctx, const uint8_t* src, size_t len);
+// Write the top-left width x height of the GDDRAM as a plain PBM (P1, 1 = lit pixel).
+void ssd1306_model_write_pbm(const ssd1306_model_t* m, uint32_t width, uint32_t height, FILE* fp);
@@ -0,0 +1,186 @@
+/*------------------------------------------------------/
+/ Copyright (c) 2026, Elehobica
+/ Released under the BSD-2-Clause
+/ refer to https://opensource.org/licenses/BSD-2-Clause
+/------------------------------------------------------*/
+
+// Fixture of the host unit tests (host/tests/test_*.cpp). Each test program includes
+// pico_battery_op.cpp through this header to reach its static functions and state, so there is
+// one library instance per program; _setup() puts it back to a fresh boot between cases.
+
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "host_sdk.h"
+#include "pico_battery_op.cpp"
+
+static const uint64_t TICK_US = TIMER_ADC_TICK_MS * 1000; // the 20 Hz sampler period
+
+// === Checks ==============================================================
+static uint32_t _checks = 0;
+static uint32_t _failures = 0;
+
+#define CHECK(cond) _check((cond), #cond, __FILE__, __LINE__)
+#define CHECK_EQ(a, b) _check((a) == (b), #a " == " #b, __FILE__, __LINE__)
+
+static inline void _check(bool ok, const char* expr, const char* file, int line)
+{
+    _checks++;
+    if (!ok) {
+        _failures++;
+        printf("%s:%d: CHECK failed: %s\n", file, line, expr);
+    }
+}
+
+// Summary line and exit code of a test program
+static inline int _test_result(const char* name)
+{
+    printf("%s: %u checks, %u failed\n", name, _checks, _failures);
+    return (_failures == 0) ? 0 : 1;
+}
+
+// === Callback log ========================================================
+// The callbacks append one token each to _log ("state:Active", "defer:Sleep", ...), so a test
+// can compare what the application saw with an expected sequence.
+static const char* const STATE_NAMES[] = { "Idle", "Active", "ActiveEco" };
+static const char* const REASON_NAMES[] = { "None", "Sleep", "Shutdown", "LowBattery", "Charge" };
+static const char* const BUTTON_NAMES[] = {
+    "PowerSingle", "PowerDouble", "PowerTriple", "PowerLong", "PowerLongLong",
+    "UserSingle", "UserDouble", "UserTriple", "UserLong", "UserLongLong", "Others"
+};
+
+static std::string _log;
+static uint32_t _forwarded = 0;
+static button_action_t _forwarded_act = ButtonOthers;
+static uint64_t _forwarded_at_us = 0;
+static uint32_t _preempted = 0;
+static pbo_deferred_reason_t _preempted_reason = PboDeferredNone;
+static pbo_deferred_reason_t _preempted_by = PboDeferredNone;
+
+static inline void _log_token(const std::string& token)
+{
+    _log += _log.empty() ? token : "," + token;
+}
+
+static inline void _on_state_changed(pbo_state_t new_state, pbo_state_t prev_state)
+{
+    (void) prev_state;
+    _log_token(std::string("state:") + STATE_NAMES[new_state]);
+}
+
+static inline void _on_deferred(pbo_deferred_reason_t reason)
+{
+    _log_token(std::string("defer:") + REASON_NAMES[reason]);
+}
+
+static inline void _on_deferred_preempted(pbo_deferred_reason_t preempted, pbo_deferred_reason_t by)
+{
+    _preempted++;
+    _preempted_reason = preempted;
+    _preempted_by = by;
+    _log_token(std::string("preempt:") + REASON_NAMES[preempted] + ">" + REASON_NAMES[by]);
+}
+
+static inline void _on_button_event(button_action_t btn_act)
+{
+    _forwarded++;
+    _forwarded_act = btn_act;
+    _forwarded_at_us = host_time_us();
+    _log_token(std::string("button:") + BUTTON_NAMES[btn_act]);
+}
+
+static inline void _on_enter_dormant()
+{
+    _log_token("dormant");
+}
+
+static inline void _on_exit_dormant()
+{
+    _log_token("wake");
+}
+
+// Take the log accumulated so far and start a new one
+static inline std::string _take_log()
+{
+    std::string log = _log;
+    _log.clear();
+    return log;
+}
+
+// === Setup ===============================================================
+static inline uint16_t _adc_raw_for(float volt)
+{
+    return (uint16_t) lroundf((volt - DEFAULT_BATT_CALIB_COEF_B) / DEFAULT_BATT_CALIB_COEF_A / ADC_REF_VOLTAGE * 4095.0f);
+}
+
+// Library state a reset clears but pbo_init() leaves alone (it relies on the zeroed .bss)
+static inline void _reset_library()
+{
+    _usb_clocks_on = true;
+    _dormant_total_ms = 0;
+    _wall_base_ms = 0;
+    _num_domains = 0;
+    _domains_up = false;
+    memset(_timers, 0, sizeof(_timers));
+    for (uint32_t i = 0; i < NUM_BTN_HISTORY; i++) {
+        button_prv[i] = ButtonOpen;
+    }
+    button_repeat_count = LONG_LONG_PUSH_COUNT + 1;
+}
+
+// Boot the library on battery (switch released, 3.9 V) with cfg, then put it in state with
+// nothing pending. The fixture callbacks are installed; the ones set in cfg are replaced.
+static inline void _setup(pbo_config_t cfg, pbo_state_t state)
+{
+    host_reset();
+    host_gpio_set_input(PIN_USB_POWER_DETECT, false);
+    host_adc_set(ADC_PIN_BATT_LVL, _adc_raw_for(3.9f));
+    host_adc_set(ADC_INPUT_TEMP, 876); // 0.706 V: 27 degC
+    cfg.callbacks.on_state_changed = _on_state_changed;
+    cfg.callbacks.on_deferred = _on_deferred;
+    cfg.callbacks.on_button_event = _on_button_event;
+    cfg.callbacks.on_deferred_preempted = _on_deferred_preempted;
+    cfg.callbacks.on_enter_dormant = _on_enter_dormant;
+    cfg.callbacks.on_exit_dormant = _on_exit_dormant;
+    _reset_library();
+    pbo_init(&cfg);
+    pbo_start();
+    _state = state;
+    _state_entered_ms = _now_ms();
+    _boot = false;
+    _deferred = PboDeferredNone;
+    _deferred_queued = PboDeferredNone;
+    _restart_inactivity();
+    _usb_seen = false;
+    button_repeat_count = 0; // switches released since boot: the next press counts
+    _log.clear();
+    _forwarded = 0;
+    _forwarded_act = ButtonOthers;
+    _forwarded_at_us = 0;
+    _preempted = 0;
+    _preempted_reason = PboDeferredNone;
+    _preempted_by = PboDeferredNone;
+}
+
+// === Timeline ============================================================
+// Run the main loop for ms of virtual time: one sampler tick, then one pbo_process(), as an
+// application loop woken by the 20 Hz interrupt does.
+static inline void _run_ms(uint64_t ms)
+{
+    for (uint64_t t = 0; t < ms * 1000; t += TICK_US) {
+        host_advance_us(TICK_US);
+        pbo_process();
+    }
+}
+
+// Hold a switch (active low) for hold_ms, then release it
+static inline void _push(uint32_t pin, uint64_t hold_ms)
+{
+    host_gpio_set_input(pin, false);
+    _run_ms(hold_ms);
+    host_gpio_set_input(pin, true);
+}
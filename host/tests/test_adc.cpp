@@ -0,0 +1,116 @@
+/*------------------------------------------------------/
+/ Copyright (c) 2026, Elehobica
+/ Released under the BSD-2-Clause
+/ refer to https://opensource.org/licenses/BSD-2-Clause
+/------------------------------------------------------*/
+
+// Battery sampling through the stand-in's ADC: the temperature sensor conversion, and the
+// adaptive sampling interval along a synthetic discharge curve.
+
+#include <vector>
+
+#include "pbo_test.h"
+
+// === Temperature sensor ==================================================
+// The sensor is powered only around its conversion, and the first ADC4 conversion after
+// enabling it (unsettled in the stand-in) is discarded whatever the number of battery samples.
+static void test_temp_sensor_per_sample()
+{
+    pbo_config_t cfg = pbo_get_default_config();
+    _setup(cfg, PboStateActive);
+    CHECK(!host_adc_temp_sensor_enabled());
+    CHECK(fabsf(pbo_get_die_temperature() - 27.0f) < 1.0f); // converted in pbo_init()
+    for (uint32_t samples : { 1u, 2u, 4u }) {
+        uint32_t conversions = host_adc_conversions();
+        _sample_battery_voltage(samples);
+        CHECK_EQ(host_adc_conversions() - conversions, samples + 2); // the discarded one included
+        CHECK(!host_adc_temp_sensor_enabled());
+        CHECK(fabsf(pbo_get_die_temperature() - 27.0f) < 1.0f);
+    }
+}
+
+// === Adaptive interval ===================================================
+// A plateau, a slow decline, then the knee down to the cutoff (2.9 V)
+static float _discharge_curve(float t_s)
+{
+    if (t_s < 600.0f) {
+        return 3.80f;
+    } else if (t_s < 900.0f) {
+        return 3.80f - 0.10f * (t_s - 600.0f) / 300.0f;
+    }
+    float v = 3.70f - 0.75f * (t_s - 900.0f) / 100.0f;
+    return (v > 2.95f) ? v : 2.95f;
+}
+
+struct sample_t {
+    float t_s;
+    float volt;
+    float interval_s; // since the previous sample
+};
+
+// Run the curve for seconds and return every battery sample the sampler took
+static std::vector<sample_t> _sample_curve(uint32_t seconds)
+{
+    std::vector<sample_t> samples;
+    float last_s = 0.0f;
+    uint32_t ticks = seconds * 1000 / TIMER_ADC_TICK_MS;
+    for (uint32_t i = 0; i < ticks; i++) {
+        float t_s = (float) host_time_us() / 1e6f;
+        host_adc_set(ADC_PIN_BATT_LVL, _adc_raw_for(_discharge_curve(t_s)));
+        uint32_t conversions = host_adc_conversions();
+        host_advance_us(TICK_US);
+        pbo_process();
+        if (host_adc_conversions() != conversions) {
+            float now_s = (float) host_time_us() / 1e6f;
+            samples.push_back({ now_s, pbo_get_battery_voltage(), now_s - last_s });
+            last_s = now_s;
+        }
+    }
+    return samples;
+}
+
+static void test_adaptive_interval()
+{
+    pbo_config_t cfg = pbo_get_default_config();
+    cfg.batt_check_min_ms = 1000;
+    cfg.batt_check_max_ms = 20000;
+    cfg.batt_check_margin_v = 0.1f;
+    _setup(cfg, PboStateActive);
+    std::vector<sample_t> samples = _sample_curve(1000);
+    CHECK(samples.size() > 10);
+
+    float threshold = pbo_get_low_battery_threshold();
+    float plateau_min = 1e9f;
+    float knee_prev = 1e9f;
+    float knee_last = 0.0f;
+    bool knee_shrinking = true;
+    float margin_max = 0.0f;
+    for (size_t i = 1; i < samples.size(); i++) {
+        const sample_t& s = samples[i];
+        CHECK(s.interval_s <= 20.0f + 0.06f);
+        if (s.t_s > 300.0f && s.t_s < 600.0f) {
+            plateau_min = (s.interval_s < plateau_min) ? s.interval_s : plateau_min;
+        } else if (samples[i - 1].t_s > 900.0f && s.volt > threshold + 0.1f) {
+            knee_shrinking &= (s.interval_s <= knee_prev);
+            knee_prev = s.interval_s;
+            knee_last = s.interval_s;
+        }
+        if (samples[i - 1].volt < threshold + 0.1f) {
+            margin_max = (s.interval_s > margin_max) ? s.interval_s : margin_max;
+        }
+    }
+    // lengthened on the flat plateau: set by the headroom alone (0.8 V of 1.2 V)
+    CHECK(plateau_min > 10.0f);
+    // shortened sample by sample down the knee, ahead of the margin, by the measured drop rate
+    CHECK(knee_shrinking);
+    CHECK(knee_last > 0.0f && knee_last < plateau_min / 4.0f);
+    // batt_check_min_ms once within the margin of the threshold
+    CHECK(margin_max > 0.0f && margin_max < 1.0f + 0.06f);
+}
+
+int main()
+{
+    test_temp_sensor_per_sample();
+    test_adaptive_interval();
+    return _test_result("test_adc");
+}
@@ -0,0 +1,125 @@
+/*------------------------------------------------------/
+/ Copyright (c) 2026, Elehobica
+/ Released under the BSD-2-Clause
+/ refer to https://opensource.org/licenses/BSD-2-Clause
+/------------------------------------------------------*/
+
+// Battery levels: the hysteresis of _battery_level_from() and the low-battery cutoff, and noisy
+// discharge / charge traces through the ADC that must cross every level boundary once.
+
+#include "pbo_test.h"
+
+// === Battery levels ======================================================
+static uint32_t _level_at(float volt, uint32_t from)
+{
+    _bat_volt = volt;
+    return _battery_level_from(from);
+}
+
+static void test_battery_level_hysteresis()
+{
+    pbo_config_t cfg = pbo_get_default_config();
+    cfg.battery_levels_num = 2;
+    cfg.battery_levels[0] = 3.6f;
+    cfg.battery_levels[1] = 3.4f;
+    cfg.battery_level_hysteresis_v = 0.05f;
+    _setup(cfg, PboStateActive);
+
+    // down as soon as below a threshold, several at once on a fast drop
+    CHECK_EQ(_level_at(3.61f, 0), 0u);
+    CHECK_EQ(_level_at(3.59f, 0), 1u);
+    CHECK_EQ(_level_at(3.30f, 0), 2u);
+    CHECK_EQ(_level_at(2.80f, 1), 3u);
+    // up only hysteresis above the threshold
+    CHECK_EQ(_level_at(3.62f, 1), 1u);
+    CHECK_EQ(_level_at(3.66f, 1), 0u);
+    CHECK_EQ(_level_at(3.44f, 2), 2u);
+    CHECK_EQ(_level_at(3.46f, 2), 1u);
+    CHECK_EQ(_level_at(3.70f, 2), 0u);
+    // the last level is the low-battery cutoff (2.9 V)
+    CHECK_EQ(_level_at(2.93f, 3), 3u);
+    CHECK_EQ(_level_at(2.96f, 3), 2u);
+    _batt_level = 3;
+    CHECK(_get_low_battery());
+    _batt_level = 2;
+    CHECK(!_get_low_battery());
+}
+
+// === Noisy traces ========================================================
+// A cell voltage ramp with ADC noise below the hysteresis (+-20 mV against 50 mV): every level
+// boundary must be reported once, never flapping back while the voltage hovers around it.
+static uint32_t _level_changes = 0;
+static bool _level_monotonic = true;
+static int32_t _level_step = 0; // +1 discharging, -1 charging
+
+static void _on_battery_level(uint32_t level, uint32_t prev_level)
+{
+    _level_changes++;
+    if ((int32_t) level - (int32_t) prev_level != _level_step) {
+        _level_monotonic = false;
+    }
+}
+
+static uint32_t _noise_seed = 1;
+
+static float _noise(float amplitude)
+{
+    _noise_seed = _noise_seed * 1664525u + 1013904223u;
+    return ((float) (_noise_seed >> 8) / (float) (1u << 24) * 2.0f - 1.0f) * amplitude;
+}
+
+// Ramp from -> to over seconds, a fresh noisy value on every sampler tick
+static void _run_ramp(float from, float to, uint32_t seconds)
+{
+    uint32_t ticks = seconds * 1000 / TIMER_ADC_TICK_MS;
+    for (uint32_t i = 0; i < ticks; i++) {
+        float volt = from + (to - from) * (float) i / (float) ticks;
+        host_adc_set(ADC_PIN_BATT_LVL, _adc_raw_for(volt + _noise(0.02f)));
+        host_advance_us(TICK_US);
+        pbo_process();
+    }
+}
+
+static void test_battery_level_noisy_trace()
+{
+    pbo_config_t cfg = pbo_get_default_config();
+    cfg.battery_levels_num = 2;
+    cfg.battery_levels[0] = 3.6f;
+    cfg.battery_levels[1] = 3.4f;
+    cfg.battery_level_hysteresis_v = 0.05f;
+    cfg.batt_check_min_ms = 1000;
+    cfg.batt_check_max_ms = 1000;
+    cfg.callbacks.on_battery_level = _on_battery_level;
+
+    // discharge 3.8 V -> 2.7 V across 3.6 V, 3.4 V and the 2.9 V cutoff
+    _setup(cfg, PboStateActive);
+    CHECK_EQ(pbo_get_battery_level(), 0u);
+    _level_changes = 0;
+    _level_monotonic = true;
+    _level_step = 1;
+    _run_ramp(3.8f, 2.7f, 1100);
+    CHECK_EQ(_level_changes, 3u);
+    CHECK(_level_monotonic);
+    CHECK_EQ(pbo_get_battery_level(), 3u);
+
+    // charge back up: each boundary once more, upward
+    _setup(cfg, PboStateIdle);
+    host_adc_set(ADC_PIN_BATT_LVL, _adc_raw_for(2.7f));
+    _measure_battery_burst();
+    _batt_level = _battery_level_from(0);
+    CHECK_EQ(pbo_get_battery_level(), 3u);
+    _level_changes = 0;
+    _level_monotonic = true;
+    _level_step = -1;
+    _run_ramp(2.7f, 3.8f, 1100);
+    CHECK_EQ(_level_changes, 3u);
+    CHECK(_level_monotonic);
+    CHECK_EQ(pbo_get_battery_level(), 0u);
+}
+
+int main()
+{
+    test_battery_level_hysteresis();
+    test_battery_level_noisy_trace();
+    return _test_result("test_battery_levels");
+}
@@ -0,0 +1,126 @@
+/*------------------------------------------------------/
+/ Copyright (c) 2026, Elehobica
+/ Released under the BSD-2-Clause
+/ refer to https://opensource.org/licenses/BSD-2-Clause
+/------------------------------------------------------*/
+
+// Gesture latency: press / release timelines on the virtual clock, from the edge that decides
+// the gesture to the on_button_event() call, for the fire-on-press Single, the release of the
+// last usable click, and the click window otherwise.
+
+#include "pbo_test.h"
+
+static const uint32_t PIN_USER_SW = 19;
+
+static pbo_config_t _user_config(uint32_t gestures)
+{
+    pbo_config_t cfg = pbo_get_default_config();
+    cfg.pin_user_sw = PIN_USER_SW;
+    cfg.user_gestures = gestures;
+    return cfg;
+}
+
+// Clicks of press_ms with gap_ms between them; returns the time of the last release [us]
+static uint64_t _clicks(uint32_t count, uint64_t press_ms, uint64_t gap_ms)
+{
+    uint64_t released_us = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (i > 0) {
+            _run_ms(gap_ms);
+        }
+        _push(PIN_USER_SW, press_ms);
+        released_us = host_time_us();
+    }
+    return released_us;
+}
+
+// Latency [ms] from from_us to the forwarded event (run for up to 2 s), -1 if none came
+static int64_t _latency_ms(uint64_t from_us)
+{
+    for (uint32_t t = 0; t < 2000 && _forwarded == 0; t += TIMER_ADC_TICK_MS) {
+        host_advance_us(TICK_US);
+        pbo_process();
+    }
+    return (_forwarded == 0) ? -1 : (int64_t) (_forwarded_at_us - from_us) / 1000;
+}
+
+// === Fire on press =======================================================
+// Nothing but Single enabled: reported on the first tick that sees the press, before release
+static void test_latency_fire_on_press()
+{
+    _setup(_user_config(PBO_GESTURE_SINGLE), PboStateActive);
+    uint64_t pressed_us = host_time_us();
+    host_gpio_set_input(PIN_USER_SW, false);
+    _run_ms(TIMER_ADC_TICK_MS);
+    CHECK_EQ(_forwarded, 1u);
+    CHECK_EQ(_forwarded_act, ButtonUserSingle);
+    CHECK((_forwarded_at_us - pressed_us) / 1000 <= TIMER_ADC_TICK_MS);
+    // held on: no repeat, nothing more on release
+    _run_ms(3000);
+    host_gpio_set_input(PIN_USER_SW, true);
+    _run_ms(1000);
+    CHECK_EQ(_forwarded, 1u);
+}
+
+// === Release of the last usable click ====================================
+// The release that reaches the most clicks the enabled gestures use decides at once
+static void test_latency_fast_release()
+{
+    // Single only besides Long: the first release
+    _setup(_user_config(PBO_GESTURE_SINGLE | PBO_GESTURE_LONG), PboStateActive);
+    uint64_t released_us = _clicks(1, 150, 0);
+    int64_t latency = _latency_ms(released_us);
+    CHECK_EQ(_forwarded_act, ButtonUserSingle);
+    CHECK(latency >= 0 && latency <= (int64_t) TIMER_ADC_TICK_MS);
+
+    // up to Double: the second release
+    _setup(_user_config(PBO_GESTURE_SINGLE | PBO_GESTURE_DOUBLE), PboStateActive);
+    released_us = _clicks(2, 150, 150);
+    latency = _latency_ms(released_us);
+    CHECK_EQ(_forwarded_act, ButtonUserDouble);
+    CHECK(latency >= 0 && latency <= (int64_t) TIMER_ADC_TICK_MS);
+
+    // up to Triple: the third release
+    _setup(_user_config(PBO_GESTURE_ALL), PboStateActive);
+    released_us = _clicks(3, 150, 150);
+    latency = _latency_ms(released_us);
+    CHECK_EQ(_forwarded_act, ButtonUserTriple);
+    CHECK(latency >= 0 && latency <= (int64_t) TIMER_ADC_TICK_MS);
+    CHECK_EQ(_forwarded, 1u);
+}
+
+// === Click window ========================================================
+// Fewer clicks than the gestures may use: decided once the click window has passed
+static void test_latency_click_window()
+{
+    const int64_t window_ms = RELEASE_IGNORE_COUNT * TIMER_ADC_TICK_MS;
+    _setup(_user_config(PBO_GESTURE_ALL), PboStateActive);
+    uint64_t released_us = _clicks(1, 150, 0);
+    int64_t latency = _latency_ms(released_us);
+    CHECK_EQ(_forwarded_act, ButtonUserSingle);
+    CHECK(latency >= window_ms - (int64_t) TIMER_ADC_TICK_MS && latency <= window_ms + (int64_t) TIMER_ADC_TICK_MS);
+
+    _setup(_user_config(PBO_GESTURE_ALL), PboStateActive);
+    released_us = _clicks(2, 150, 150);
+    latency = _latency_ms(released_us);
+    CHECK_EQ(_forwarded_act, ButtonUserDouble);
+    CHECK(latency >= window_ms - (int64_t) TIMER_ADC_TICK_MS && latency <= window_ms + (int64_t) TIMER_ADC_TICK_MS);
+
+    // Long fires while still held, at LONG_PUSH_COUNT ticks
+    _setup(_user_config(PBO_GESTURE_ALL), PboStateActive);
+    uint64_t pressed_us = host_time_us();
+    host_gpio_set_input(PIN_USER_SW, false);
+    latency = _latency_ms(pressed_us);
+    CHECK_EQ(_forwarded_act, ButtonUserLong);
+    CHECK(latency >= (int64_t) (LONG_PUSH_COUNT * TIMER_ADC_TICK_MS)
+          && latency <= (int64_t) ((LONG_PUSH_COUNT + 2) * TIMER_ADC_TICK_MS));
+    host_gpio_set_input(PIN_USER_SW, true);
+}
+
+int main()
+{
+    test_latency_fire_on_press();
+    test_latency_fast_release();
+    test_latency_click_window();
+    return _test_result("test_buttons");
+}
@@ -0,0 +1,40 @@
+/*------------------------------------------------------/
+/ Copyright (c) 2026, Elehobica
+/ Released under the BSD-2-Clause
+/ refer to https://opensource.org/licenses/BSD-2-Clause
+/------------------------------------------------------*/
+
+// Clock gating: no clock may run from PLL_USB while it is powered down, checked through the
+// stand-in's clock tree.
+
+#include "pbo_test.h"
+
+// === USB clock gating ====================================================
+// No clock may still run from PLL_USB when it is powered down.
+static void test_usb_clock_gating()
+{
+    pbo_config_t cfg = pbo_get_default_config();
+    _setup(cfg, PboStateActive); // boots without USB: clocks down
+    const host_clocks_t* clk = host_clocks();
+    CHECK(!clk->pll_usb_on);
+    CHECK(!clk->clk_usb_on);
+    CHECK_EQ(clk->clk_adc_auxsrc, (uint32_t) CLOCKS_CLK_ADC_CTRL_AUXSRC_VALUE_XOSC_CLKSRC);
+#if PICO_RP2040
+    CHECK_EQ(clk->clk_rtc_auxsrc, (uint32_t) CLOCKS_CLK_RTC_CTRL_AUXSRC_VALUE_XOSC_CLKSRC);
+    CHECK_EQ(clk->clk_rtc_hz, (uint32_t) RTC_CLOCK_FREQ_HZ);
+#endif
+
+    host_gpio_set_input(PIN_USB_POWER_DETECT, true);
+    _update_usb_serial();
+    CHECK(clk->pll_usb_on);
+    CHECK(clk->clk_usb_on);
+    CHECK_EQ(clk->clk_adc_auxsrc, (uint32_t) CLOCKS_CLK_ADC_CTRL_AUXSRC_VALUE_CLKSRC_PLL_USB);
+    CHECK_EQ(clk->clk_rtc_auxsrc, (uint32_t) CLOCKS_CLK_RTC_CTRL_AUXSRC_VALUE_CLKSRC_PLL_USB);
+    CHECK_EQ(clk->clk_rtc_hz, (uint32_t) RTC_CLOCK_FREQ_HZ);
+}
+
+int main()
+{
+    test_usb_clock_gating();
+    return _test_result("test_clocks");
+}
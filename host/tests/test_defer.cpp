@@ -0,0 +1,138 @@
+/*------------------------------------------------------/
+/ Copyright (c) 2026, Elehobica
+/ Released under the BSD-2-Clause
+/ refer to https://opensource.org/licenses/BSD-2-Clause
+/------------------------------------------------------*/
+
+// Deferred actions: the priorities of _request_defer() (begin, preempt, queue, duplicates, the
+// earlier deadline kept), and pbo_process() timelines of preemption and queueing with the order
+// of the callbacks the application sees.
+
+#include "pbo_test.h"
+
+// === Deferred-action priorities ==========================================
+static void test_request_defer_priority()
+{
+    pbo_config_t cfg = pbo_get_default_config();
+    _setup(cfg, PboStateActive);
+
+    _request_defer(PboDeferredSleep, 1000);
+    CHECK_EQ(_deferred, PboDeferredSleep);
+    // a Shutdown outranks the Sleep: preempted, reported
+    _request_defer(PboDeferredShutdown, 1000);
+    CHECK_EQ(_deferred, PboDeferredShutdown);
+    CHECK_EQ(_preempted, 1u);
+    CHECK_EQ(_preempted_reason, PboDeferredSleep);
+    CHECK_EQ(_preempted_by, PboDeferredShutdown);
+    // lower priority: queued; a duplicate or an equal-priority request is not
+    _request_defer(PboDeferredSleep, 2000);
+    CHECK_EQ(_deferred_queued, PboDeferredSleep);
+    CHECK_EQ(_deferred_queued_ms, 2000u);
+    _request_defer(PboDeferredCharge, 3000);
+    CHECK_EQ(_deferred_queued, PboDeferredSleep);
+    _request_defer(PboDeferredShutdown, 1000);
+    CHECK_EQ(_deferred, PboDeferredShutdown);
+    CHECK_EQ(_preempted, 1u);
+    // low battery outranks everything and drops the queued Sleep
+    _request_defer(PboDeferredLowBattery, 1000);
+    CHECK_EQ(_deferred, PboDeferredLowBattery);
+    CHECK_EQ(_deferred_queued, PboDeferredNone);
+    CHECK_EQ(_preempted, 2u);
+    CHECK(!_deferred_cancelable(_deferred));
+
+    // low battery preempting a Shutdown keeps the Shutdown's deadline when that is earlier
+    _setup(cfg, PboStateActive);
+    _request_defer(PboDeferredShutdown, 3000);
+    host_advance_us(2000 * 1000);
+    _request_defer(PboDeferredLowBattery, 3000);
+    CHECK_EQ(_deferred, PboDeferredLowBattery);
+    CHECK(absolute_time_diff_us(get_absolute_time(), _defer_deadline) <= 1000 * 1000);
+    _setup(cfg, PboStateActive);
+    _request_defer(PboDeferredShutdown, 10000);
+    _request_defer(PboDeferredLowBattery, 3000);
+    CHECK(absolute_time_diff_us(get_absolute_time(), _defer_deadline) <= 3000 * 1000);
+    // a Sleep is not terminal: the preempting Shutdown gets its full delay
+    _setup(cfg, PboStateActive);
+    _request_defer(PboDeferredSleep, 1000);
+    _request_defer(PboDeferredShutdown, 3000);
+    CHECK_EQ(absolute_time_diff_us(get_absolute_time(), _defer_deadline), (int64_t) 3000 * 1000);
+
+    // a higher-priority queued request survives a preemption it outranks
+    _setup(cfg, PboStateActive);
+    _request_defer(PboDeferredSleep, 1000);
+    _deferred_queued = PboDeferredLowBattery;
+    _request_defer(PboDeferredShutdown, 1000);
+    CHECK_EQ(_deferred, PboDeferredShutdown);
+    CHECK_EQ(_deferred_queued, PboDeferredLowBattery);
+}
+
+// === pbo_process() timelines =============================================
+// Active with a Shutdown announced by a POWER long-long push (2 s hold, 10 s announce) and the
+// 5 s inactivity Sleep queued behind it. Returns at 7.5 s.
+static void _shutdown_with_sleep_queued()
+{
+    pbo_config_t cfg = pbo_get_default_config();
+    cfg.shutdown_defer_ms = 10000;
+    cfg.sleep_defer_ms = 3000;
+    cfg.idle_sleep_ms = 5000;
+    cfg.batt_check_min_ms = 1000;
+    cfg.batt_check_max_ms = 1000;
+    _setup(cfg, PboStateActive);
+    _push(_cfg.pin_power_sw, 2100);
+    CHECK_EQ(_take_log(), "button:PowerLong,defer:Shutdown");
+    _run_ms(5400);
+    CHECK_EQ(_deferred, PboDeferredShutdown);
+    CHECK_EQ(_deferred_queued, PboDeferredSleep); // queued silently
+    CHECK_EQ(_take_log(), "");
+}
+
+// Run until the state is left or limit_ms passes; returns the virtual time [ms]
+static uint64_t _run_until_state_change(uint64_t limit_ms)
+{
+    pbo_state_t from = _state;
+    for (uint64_t t = 0; t < limit_ms && _state == from; t += TIMER_ADC_TICK_MS) {
+        host_advance_us(TICK_US);
+        pbo_process();
+    }
+    return host_time_us() / 1000;
+}
+
+static void test_defer_timelines()
+{
+    // low battery preempts the Shutdown: reported once, the queued Sleep is dropped, and the
+    // Shutdown's earlier deadline (12 s) is kept
+    _shutdown_with_sleep_queued();
+    host_adc_set(ADC_PIN_BATT_LVL, _adc_raw_for(2.7f));
+    _run_ms(1500);
+    CHECK_EQ(_take_log(), "preempt:Shutdown>LowBattery,defer:LowBattery");
+    CHECK_EQ(_deferred_queued, PboDeferredNone);
+    uint64_t at_ms = _run_until_state_change(20000);
+    CHECK_EQ(_state, PboStateIdle);
+    CHECK(at_ms <= 12100 + 50);
+    _run_ms(5000);
+    CHECK_EQ(_take_log(), "state:Idle");
+
+    // the queued Sleep begins once the Shutdown is canceled, without a preemption
+    _shutdown_with_sleep_queued();
+    CHECK(pbo_cancel_deferred());
+    _run_ms(100);
+    CHECK_EQ(_take_log(), "defer:Sleep");
+    _run_ms(3000);
+    CHECK_EQ(_take_log(), "dormant,wake");
+    CHECK_EQ(_preempted, 0u);
+
+    // a Shutdown that runs supersedes the Sleep queued behind it
+    _shutdown_with_sleep_queued();
+    _run_until_state_change(10000);
+    _run_ms(5000);
+    CHECK_EQ(_take_log(), "state:Idle");
+    CHECK_EQ(_deferred, PboDeferredNone);
+    CHECK_EQ(_deferred_queued, PboDeferredNone);
+}
+
+int main()
+{
+    test_request_defer_priority();
+    test_defer_timelines();
+    return _test_result("test_defer");
+}
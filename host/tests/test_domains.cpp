@@ -0,0 +1,188 @@
+/*------------------------------------------------------/
+/ Copyright (c) 2026, Elehobica
+/ Released under the BSD-2-Clause
+/ refer to https://opensource.org/licenses/BSD-2-Clause
+/------------------------------------------------------*/
+
+// Peripheral power domains on the virtual clock: the bring-up order of _domain_next(), the
+// settle delays run concurrently, pbo_domains_are_up() around a Sleep, and the pins kept out
+// of the low-leakage sweep.
+
+#include "pbo_test.h"
+
+// === Power domains =======================================================
+static void test_domains_hold_mask()
+{
+    pbo_config_t cfg = pbo_get_default_config();
+    _setup(cfg, PboStateActive);
+    pbo_domain_t sw = {};
+    sw.pin_power = 14;              // load switch: kept driven off without being listed
+    sw.hold_mask = 1u << 2;
+    pbo_domain_t fixed = {};
+    fixed.pin_power = PBO_PIN_UNUSED;
+    CHECK(pbo_domain_register(&sw) >= 0);
+    CHECK(pbo_domain_register(&fixed) >= 0);
+    CHECK_EQ(_domains_hold_mask(), (1u << 14) | (1u << 2));
+}
+
+// === Bring-up order ======================================================
+static void test_domain_next()
+{
+    const uint64_t due_us[] = { 30000, 5000, 12000, 5000 };
+    CHECK_EQ(_domain_next(due_us, 4, 0xf), 1u);  // earliest; the lower index on a tie
+    CHECK_EQ(_domain_next(due_us, 4, 0xd), 3u);
+    CHECK_EQ(_domain_next(due_us, 4, 0x5), 2u);
+    CHECK_EQ(_domain_next(due_us, 4, 0x1), 0u);
+}
+
+// Each init records when it ran and whether every switch was already on
+static const uint32_t DOMAIN_PINS[] = { 10, 11, 12 };
+static const uint32_t DOMAIN_SETTLE_MS[] = { 30, 5, 12 };
+static uint64_t _up_from_us = 0;
+static uint32_t _init_order[3];
+static uint64_t _init_at_ms[3];
+static uint32_t _num_inits = 0;
+static bool _all_on_at_init = true;
+static bool _up_during_init = false;
+static uint64_t _init_overrun_us = 0;
+static uint32_t _deinit_order[3];
+static uint32_t _num_deinits = 0;
+
+static void _domain_init(uint32_t i)
+{
+    for (uint32_t pin : DOMAIN_PINS) {
+        _all_on_at_init &= host_gpio_output(pin);
+    }
+    _up_during_init |= pbo_domains_are_up();
+    _init_order[_num_inits] = i;
+    _init_at_ms[_num_inits] = (host_time_us() - _up_from_us) / 1000;
+    _num_inits++;
+    host_skip_us(_init_overrun_us);
+    _init_overrun_us = 0;
+}
+
+static void _init0() { _domain_init(0); }
+static void _init1() { _domain_init(1); }
+static void _init2() { _domain_init(2); }
+static void _deinit0() { _deinit_order[_num_deinits++] = 0; }
+static void _deinit1() { _deinit_order[_num_deinits++] = 1; }
+static void _deinit2() { _deinit_order[_num_deinits++] = 2; }
+
+static void _register_domains()
+{
+    void (*inits[])() = { _init0, _init1, _init2 };
+    void (*deinits[])() = { _deinit0, _deinit1, _deinit2 };
+    for (uint32_t i = 0; i < 3; i++) {
+        pbo_domain_t d = {};
+        d.pin_power = DOMAIN_PINS[i];
+        d.settle_ms = DOMAIN_SETTLE_MS[i];
+        d.init = inits[i];
+        d.deinit = deinits[i];
+        CHECK_EQ(pbo_domain_register(&d), (int) i);
+    }
+    _num_inits = 0;
+    _num_deinits = 0;
+    _all_on_at_init = true;
+    _up_during_init = false;
+}
+
+static void test_domains_power_up_order()
+{
+    pbo_config_t cfg = pbo_get_default_config();
+    _setup(cfg, PboStateActive);
+    _register_domains();
+    CHECK(!pbo_domains_are_up());
+
+    // all switched on together: each init runs at its own settle time, 30 ms in total
+    _up_from_us = host_time_us();
+    pbo_domains_power_up();
+    CHECK(pbo_domains_are_up());
+    CHECK(_all_on_at_init);
+    CHECK(!_up_during_init);
+    CHECK_EQ(_num_inits, 3u);
+    CHECK_EQ(_init_order[0], 1u);
+    CHECK_EQ(_init_order[1], 2u);
+    CHECK_EQ(_init_order[2], 0u);
+    CHECK_EQ(_init_at_ms[0], 5u);
+    CHECK_EQ(_init_at_ms[1], 12u);
+    CHECK_EQ(_init_at_ms[2], 30u);
+    CHECK_EQ((host_time_us() - _up_from_us) / 1000, 30u);
+    pbo_domains_power_up(); // already up: no second init
+    CHECK_EQ(_num_inits, 3u);
+
+    // down in reverse registration order, switches off
+    _domains_power_down();
+    CHECK(!pbo_domains_are_up());
+    CHECK_EQ(_num_deinits, 3u);
+    CHECK_EQ(_deinit_order[0], 2u);
+    CHECK_EQ(_deinit_order[1], 1u);
+    CHECK_EQ(_deinit_order[2], 0u);
+    for (uint32_t pin : DOMAIN_PINS) {
+        CHECK(!host_gpio_output(pin));
+    }
+
+    // an init that overruns the next deadline: that one runs at once, the last one on time
+    _num_inits = 0;
+    _init_overrun_us = 20000; // the 5 ms domain's init takes 20 ms
+    _up_from_us = host_time_us();
+    pbo_domains_power_up();
+    CHECK_EQ(_init_at_ms[0], 5u);
+    CHECK_EQ(_init_at_ms[1], 25u);
+    CHECK_EQ(_init_at_ms[2], 30u);
+}
+
+// pbo_domains_are_up() through a Sleep: down before on_enter_dormant(), up again only after the
+// longest settle time once awake, before on_exit_dormant()
+static bool _up_at_enter = true;
+static bool _up_at_exit = false;
+static uint64_t _woke_at_us = 0;
+static uint64_t _exit_at_us = 0;
+
+static void _enter_dormant_check()
+{
+    _up_at_enter = pbo_domains_are_up();
+}
+
+static void _exit_dormant_check()
+{
+    _up_at_exit = pbo_domains_are_up();
+    _exit_at_us = host_time_us();
+}
+
+static uint64_t _sleep_1s(uint pin, uint64_t alarm_us)
+{
+    (void) pin;
+    (void) alarm_us;
+    _woke_at_us = host_time_us();
+    return 1000 * 1000;
+}
+
+static void test_domains_around_sleep()
+{
+    pbo_config_t cfg = pbo_get_default_config();
+    _setup(cfg, PboStateActive);
+    _register_domains();
+    pbo_domains_power_up();
+    _cb.on_enter_dormant = _enter_dormant_check;
+    _cb.on_exit_dormant = _exit_dormant_check;
+    host_set_dormant_hook(_sleep_1s);
+    _num_inits = 0;
+    _request_defer(PboDeferredSleep, 0);
+    pbo_process();
+    CHECK_EQ(host_dormant_count(), 1u);
+    CHECK(!_up_at_enter);
+    CHECK(_up_at_exit);
+    CHECK_EQ(_num_inits, 3u);
+    CHECK(_exit_at_us - _woke_at_us >= 30 * 1000);
+    CHECK(pbo_domains_are_up());
+    host_set_dormant_hook(nullptr);
+}
+
+int main()
+{
+    test_domains_hold_mask();
+    test_domain_next();
+    test_domains_power_up_order();
+    test_domains_around_sleep();
+    return _test_result("test_domains");
+}
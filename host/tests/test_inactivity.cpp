@@ -0,0 +1,136 @@
+/*------------------------------------------------------/
+/ Copyright (c) 2026, Elehobica
+/ Released under the BSD-2-Clause
+/ refer to https://opensource.org/licenses/BSD-2-Clause
+/------------------------------------------------------*/
+
+// Inactivity timers over hours of virtual time: expiry in PboStateActive and
+// PboStateActiveEco, the restart on a button event, and the timers still running while a
+// deferred action is pending.
+
+#include "pbo_test.h"
+
+static const uint64_t HOUR_MS = 60 * 60 * 1000;
+static const uint32_t PIN_USER_SW = 19;
+
+static pbo_config_t _inactivity_config()
+{
+    pbo_config_t cfg = pbo_get_default_config();
+    cfg.pin_user_sw = PIN_USER_SW;
+    cfg.sleep_defer_ms = 5000;
+    cfg.shutdown_defer_ms = 5000;
+    return cfg;
+}
+
+// Run until a callback is logged or limit_ms passes; returns the time it took [ms]
+static uint64_t _run_until_event(uint64_t limit_ms)
+{
+    uint64_t from_us = host_time_us();
+    while (_log.empty() && host_time_us() - from_us < limit_ms * 1000) {
+        host_advance_us(TICK_US);
+        pbo_process();
+    }
+    return (host_time_us() - from_us) / 1000;
+}
+
+static uint64_t _ms_since(uint64_t at_us)
+{
+    return (host_time_us() - at_us) / 1000;
+}
+
+static bool _near(uint64_t ms, uint64_t expected_ms)
+{
+    return ms + TIMER_ADC_TICK_MS >= expected_ms && ms <= expected_ms + TIMER_ADC_TICK_MS;
+}
+
+// === Expiry ==============================================================
+static void test_inactivity_active()
+{
+    pbo_config_t cfg = _inactivity_config();
+    cfg.idle_sleep_ms = 2 * HOUR_MS;
+    _setup(cfg, PboStateActive);
+    CHECK(_near(_run_until_event(3 * HOUR_MS), 2 * HOUR_MS));
+    CHECK_EQ(_take_log(), "defer:Sleep");
+    CHECK(_near(_run_until_event(HOUR_MS), 5000));
+    CHECK_EQ(_take_log(), "dormant,wake");
+    // the wake push is activity: the next Sleep is another 2 h away
+    CHECK(_near(_run_until_event(3 * HOUR_MS), 2 * HOUR_MS));
+    CHECK_EQ(_take_log(), "defer:Sleep");
+}
+
+static void test_inactivity_eco()
+{
+    pbo_config_t cfg = _inactivity_config();
+    cfg.idle_eco_ms = HOUR_MS / 2;
+    cfg.idle_sleep_ms = 3 * HOUR_MS;
+    _setup(cfg, PboStateActive);
+    CHECK(_near(_run_until_event(HOUR_MS), HOUR_MS / 2));
+    CHECK_EQ(_take_log(), "state:ActiveEco");
+    // Eco does not restart the period: the Sleep still comes 3 h after the last activity
+    CHECK(_near(_run_until_event(4 * HOUR_MS), 3 * HOUR_MS - HOUR_MS / 2));
+    CHECK_EQ(_take_log(), "defer:Sleep");
+    CHECK_EQ(_state, PboStateActiveEco);
+}
+
+// === Restart =============================================================
+static void test_inactivity_button_restart()
+{
+    pbo_config_t cfg = _inactivity_config();
+    cfg.idle_eco_ms = HOUR_MS;
+    cfg.idle_shutdown_ms = 4 * HOUR_MS;
+    _setup(cfg, PboStateActive);
+    CHECK(_near(_run_until_event(2 * HOUR_MS), HOUR_MS));
+    CHECK_EQ(_take_log(), "state:ActiveEco");
+    _run_ms(2 * HOUR_MS);
+    // a user click at 3 h leaves Eco and restarts every timer
+    _push(PIN_USER_SW, 150);
+    _run_ms(1000);
+    CHECK_EQ(_take_log(), "state:Active,button:UserSingle");
+    uint64_t click_us = _forwarded_at_us;
+    _run_until_event(2 * HOUR_MS);
+    CHECK(_near(_ms_since(click_us), HOUR_MS));
+    CHECK_EQ(_take_log(), "state:ActiveEco");
+    // the Shutdown comes 4 h after the click, not 4 h after boot
+    _run_until_event(4 * HOUR_MS);
+    CHECK(_near(_ms_since(click_us), 4 * HOUR_MS));
+    CHECK_EQ(_take_log(), "defer:Shutdown");
+}
+
+// === While a deferred action is pending ==================================
+static void test_inactivity_pending()
+{
+    // a long Sleep announce: the Shutdown timer still runs and preempts it
+    pbo_config_t cfg = _inactivity_config();
+    cfg.sleep_defer_ms = 2 * HOUR_MS;
+    cfg.idle_sleep_ms = HOUR_MS;
+    cfg.idle_shutdown_ms = 2 * HOUR_MS;
+    _setup(cfg, PboStateActive);
+    CHECK(_near(_run_until_event(2 * HOUR_MS), HOUR_MS));
+    CHECK_EQ(_take_log(), "defer:Sleep");
+    CHECK(_near(_run_until_event(2 * HOUR_MS), HOUR_MS));
+    CHECK_EQ(_take_log(), "preempt:Sleep>Shutdown,defer:Shutdown");
+
+    // a button event while pending is forwarded and restarts the timers: after the app cancels
+    // the announce, the next Sleep is a full period after the click
+    _setup(cfg, PboStateActive);
+    _run_until_event(2 * HOUR_MS);
+    CHECK_EQ(_take_log(), "defer:Sleep");
+    _run_ms(HOUR_MS / 2);
+    _push(PIN_USER_SW, 150);
+    _run_ms(1000);
+    CHECK_EQ(_take_log(), "button:UserSingle");
+    CHECK(pbo_cancel_deferred());
+    uint64_t click_us = _forwarded_at_us;
+    _run_until_event(2 * HOUR_MS);
+    CHECK(_near(_ms_since(click_us), HOUR_MS));
+    CHECK_EQ(_take_log(), "defer:Sleep");
+}
+
+int main()
+{
+    test_inactivity_active();
+    test_inactivity_eco();
+    test_inactivity_button_restart();
+    test_inactivity_pending();
+    return _test_result("test_inactivity");
+}
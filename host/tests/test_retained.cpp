@@ -0,0 +1,167 @@
+/*------------------------------------------------------/
+/ Copyright (c) 2026, Elehobica
+/ Released under the BSD-2-Clause
+/ refer to https://opensource.org/licenses/BSD-2-Clause
+/------------------------------------------------------*/
+
+// Deep Sleep record (RP2350): the retained record pack / unpack, the resume decision, and the
+// statistics carried over the power-down into a resumed pbo_init().
+
+#include "pbo_test.h"
+
+#if PICO_RP2350
+// === Record ==============================================================
+static void test_retained_record()
+{
+    pbo_config_t cfg = pbo_get_default_config();
+    retained_t rec = {};
+    rec.magic = RETAINED_MAGIC;
+    rec.pins = _retained_pins(&cfg);
+    rec.down_at_ms = 0x89abcdef;
+    rec.idle_s = 1234;
+    rec.active_s = 0x12345678;
+    rec.active_psm_s = 0x23456789;
+    rec.sleep_s = 0x3456789a;
+    rec.charging_s = 0x456789ab;
+    rec.sleep_count = 4321;
+    rec.charging_count = 77;
+    uint32_t words[NUM_RETAINED_WORDS];
+    _retained_pack(&rec, words);
+    retained_t back = {};
+    _retained_unpack(words, &back);
+    CHECK(memcmp(&back, &rec, sizeof(rec)) == 0);
+    CHECK_EQ(_retained_pins(&cfg), DEFAULT_PIN_POWER_KEEP | (DEFAULT_PIN_POWER_SW << 8));
+    // the 16-bit fields saturate instead of wrapping
+    rec.idle_s = 70000;
+    rec.sleep_count = 0x10001;
+    _retained_pack(&rec, words);
+    _retained_unpack(words, &back);
+    CHECK_EQ(back.idle_s, 0xffffu);
+    CHECK_EQ(back.sleep_count, 0xffffu);
+    CHECK_EQ(back.pins, rec.pins);
+
+    rec = {};
+    rec.magic = RETAINED_MAGIC;
+    rec.pins = _retained_pins(&cfg);
+    CHECK(_select_resume(true, &rec, &cfg));
+    CHECK(!_select_resume(false, &rec, &cfg));   // not a switched-core power-down
+    retained_t bad = rec;
+    bad.magic = 0x50424f01;                      // the previous record version
+    CHECK(!_select_resume(true, &bad, &cfg));
+    pbo_config_t moved = cfg;
+    moved.pin_power_sw = 22;                     // firmware with another pin assignment
+    CHECK(!_select_resume(true, &rec, &moved));
+}
+
+// Stats -> record -> stats: whole seconds, rounded, the power-down added to sleep_ms
+static void test_retained_stats()
+{
+    pbo_stats_t st = {};
+    st.idle_ms = 1499;
+    st.active_ms = 3600500;
+    st.active_psm_ms = 7200000;
+    st.sleep_ms = 86400999;
+    st.charging_ms = 0;
+    st.sleep_count = 12;
+    st.charging_count = 3;
+    retained_t rec = {};
+    _retained_stats_save(&st, &rec);
+    pbo_stats_t back = {};
+    _retained_stats_restore(&rec, 90000, &back);
+    CHECK_EQ(back.idle_ms, 1000u);
+    CHECK_EQ(back.active_ms, 3601000u);
+    CHECK_EQ(back.active_psm_ms, 7200000u);
+    CHECK_EQ(back.sleep_ms, 86401000u + 90000u);
+    CHECK_EQ(back.charging_ms, 0u);
+    CHECK_EQ(back.sleep_count, 12u);
+    CHECK_EQ(back.charging_count, 3u);
+}
+
+// A deep Sleep wake: pbo_init() finds the record the power-down left in POWMAN scratch
+static void _boot_from_record(const pbo_stats_t* st, uint32_t slept_ms, bool power_sw)
+{
+    pbo_config_t cfg = pbo_get_default_config();
+    cfg.deep_sleep = true;
+    cfg.max_sleep_ms = 60 * 60 * 1000;
+    host_reset();
+    host_gpio_set_input(PIN_USB_POWER_DETECT, false);
+    host_gpio_set_input(cfg.pin_power_sw, !power_sw);
+    host_adc_set(ADC_PIN_BATT_LVL, _adc_raw_for(3.9f));
+    retained_t rec = {};
+    rec.magic = RETAINED_MAGIC;
+    rec.pins = _retained_pins(&cfg);
+    rec.down_at_ms = 0u - slept_ms; // the POWMAN timer restarts at 0 here: wraps to slept_ms
+    _retained_stats_save(st, &rec);
+    uint32_t words[NUM_RETAINED_WORDS];
+    _retained_pack(&rec, words);
+    for (uint32_t i = 0; i < NUM_RETAINED_WORDS; i++) {
+        powman_hw->scratch[i] = words[i];
+    }
+    powman_hw->chip_reset = POWMAN_CHIP_RESET_HAD_SWCORE_PD_BITS;
+    _reset_library();
+    pbo_init(&cfg);
+    pbo_start();
+}
+
+static void test_retained_resume()
+{
+    pbo_stats_t st = {};
+    st.idle_ms = 2000;
+    st.active_ms = 600000;
+    st.active_psm_ms = 1200000;
+    st.sleep_ms = 3000000;
+    st.charging_ms = 4000000;
+    st.sleep_count = 5;
+    st.charging_count = 1;
+
+    // POWER push after 30 min: resumed, statistics / wall / dormant time carried over
+    _boot_from_record(&st, 30 * 60 * 1000, true);
+    CHECK(pbo_is_resumed_from_deep_sleep());
+    CHECK_EQ(pbo_get_state(), PboStateActive);
+    pbo_stats_t now = {};
+    pbo_get_stats(&now);
+    CHECK_EQ(now.idle_ms, st.idle_ms);
+    CHECK_EQ(now.active_ms, st.active_ms);
+    CHECK_EQ(now.active_psm_ms, st.active_psm_ms);
+    CHECK_EQ(now.sleep_ms, st.sleep_ms + 30 * 60 * 1000);
+    CHECK_EQ(now.charging_ms, st.charging_ms);
+    CHECK_EQ(now.sleep_count, st.sleep_count);
+    CHECK_EQ(now.charging_count, st.charging_count);
+    CHECK_EQ(pbo_get_dormant_time_ms(), now.sleep_ms + now.charging_ms);
+    uint64_t wall = now.idle_ms + now.active_ms + now.active_psm_ms + now.sleep_ms + now.charging_ms;
+    CHECK(pbo_get_wall_time_ms() >= wall && pbo_get_wall_time_ms() < wall + 1000);
+    // the record is consumed
+    for (uint32_t i = 0; i < NUM_RETAINED_WORDS; i++) {
+        CHECK_EQ(powman_hw->scratch[i], 0u);
+    }
+
+    // max_sleep_ms expired: boots released, but the statistics still survive
+    _boot_from_record(&st, 2 * 60 * 60 * 1000, false);
+    CHECK(!pbo_is_resumed_from_deep_sleep());
+    pbo_get_stats(&now);
+    CHECK_EQ(now.sleep_ms, st.sleep_ms + 2 * 60 * 60 * 1000);
+    CHECK_EQ(now.sleep_count, st.sleep_count);
+
+    // a normal boot (no switched-core power-down) starts them from 0
+    _boot_from_record(&st, 1000, true);
+    powman_hw->chip_reset = 0;
+    _reset_library();
+    for (uint32_t i = 0; i < NUM_RETAINED_WORDS; i++) {
+        powman_hw->scratch[i] = 0;
+    }
+    pbo_init(nullptr);
+    pbo_get_stats(&now);
+    CHECK_EQ(now.sleep_ms, 0u);
+    CHECK_EQ(pbo_get_dormant_time_ms(), 0u);
+}
+#endif
+
+int main()
+{
+#if PICO_RP2350
+    test_retained_record();
+    test_retained_stats();
+    test_retained_resume();
+#endif
+    return _test_result("test_retained");
+}
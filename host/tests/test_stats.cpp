@@ -0,0 +1,64 @@
+/*------------------------------------------------------/
+/ Copyright (c) 2026, Elehobica
+/ Released under the BSD-2-Clause
+/ refer to https://opensource.org/licenses/BSD-2-Clause
+/------------------------------------------------------*/
+
+// Residency statistics and the runtime estimate: the running and dormant shares of a timeline,
+// and PBO_RUNTIME_UNSUPPORTED on RP2040, where dormant cannot be timed.
+
+#include "pbo_test.h"
+
+static const uint64_t HOUR_MS = 60 * 60 * 1000;
+
+static uint64_t _sleep_3h(uint pin, uint64_t alarm_us)
+{
+    (void) pin;
+    (void) alarm_us;
+    return 3 * HOUR_MS * 1000;
+}
+
+// An hour running in PFM, then a three-hour Sleep
+static void _timeline()
+{
+    pbo_config_t cfg = pbo_get_default_config();
+    _setup(cfg, PboStateActive);
+    pbo_reset_stats();
+    _run_ms(HOUR_MS);
+    host_set_dormant_hook(_sleep_3h);
+    _request_defer(PboDeferredSleep, 0);
+    pbo_process();
+    host_set_dormant_hook(nullptr);
+}
+
+static void test_stats_estimate()
+{
+    pbo_current_model_t model = {};
+    model.active_ma = 30.0f;
+    model.active_psm_ma = 20.0f;
+    model.sleep_ma = 1.0f;
+    _timeline();
+    pbo_stats_t st;
+    pbo_get_stats(&st);
+    CHECK_EQ(st.sleep_count, 1u);
+    CHECK(st.active_psm_ms >= HOUR_MS && st.active_psm_ms < HOUR_MS + 1000);
+    CHECK_EQ(st.active_ms, 0u);
+#if PICO_RP2350
+    CHECK(st.sleep_ms >= 3 * HOUR_MS && st.sleep_ms < 3 * HOUR_MS + 1000);
+    // (1 h x 20 mA + 3 h x 1 mA) / 4 h = 5.75 mA
+    float hours = pbo_estimate_runtime_hours(&model, 2000.0f);
+    CHECK(fabsf(hours - 2000.0f / 5.75f) < 1.0f);
+    pbo_reset_stats();
+    CHECK_EQ(pbo_estimate_runtime_hours(&model, 2000.0f), 0.0f);
+#else
+    // the three hours were not measured: the running hour alone would predict 100 h
+    CHECK_EQ(st.sleep_ms, 0u);
+    CHECK_EQ(pbo_estimate_runtime_hours(&model, 2000.0f), PBO_RUNTIME_UNSUPPORTED);
+#endif
+}
+
+int main()
+{
+    test_stats_estimate();
+    return _test_result("test_stats");
+}
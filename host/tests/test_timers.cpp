@@ -0,0 +1,80 @@
+/*------------------------------------------------------/
+/ Copyright (c) 2026, Elehobica
+/ Released under the BSD-2-Clause
+/ refer to https://opensource.org/licenses/BSD-2-Clause
+/------------------------------------------------------*/
+
+// Software timers: pbo_bench_expire_timers() against idle slots and boot time, and the timers
+// around a Sleep (they neither end nor hold off dormant, and catch up once after the wake).
+
+#include "pbo_test.h"
+
+static uint32_t _timer_runs = 0;
+
+static void _count_timer_run()
+{
+    _timer_runs++;
+}
+
+// === Bench hook ==========================================================
+// pbo_bench_expire_timers() within slack_ms of boot: no wrap-around, idle slots untouched
+static void test_bench_expire_timers()
+{
+    pbo_config_t cfg = pbo_get_default_config();
+    _setup(cfg, PboStateActive);
+    host_advance_us(100 * 1000);
+    int wide = pbo_timer_start(1000, 5000, _count_timer_run);
+    int tight = pbo_timer_start(1000, 0, _count_timer_run);
+    CHECK(wide >= 0 && tight >= 0);
+    uint32_t idle = PBO_MAX_TIMERS - 1;
+    CHECK(_timers[idle].cb == nullptr);
+    _timers[idle].due_ms = 12345;
+    _timer_runs = 0;
+    pbo_bench_expire_timers();
+    CHECK_EQ(_timer_runs, 2u);
+    CHECK(_timers[wide].due_ms <= _now_ms() + 1000);
+    CHECK_EQ(_timers[idle].due_ms, 12345u);
+    pbo_timer_stop(wide);
+    pbo_timer_stop(tight);
+}
+
+// === Around a Sleep ======================================================
+static uint64_t _alarm_us = 0;
+
+static uint64_t _sleep_1h(uint pin, uint64_t alarm_us)
+{
+    (void) pin;
+    _alarm_us = alarm_us;
+    return 60ull * 60 * 1000 * 1000;
+}
+
+// A running timer arms no alarm (only max_sleep_ms does) and does not wake the chip; after
+// the wake it runs once and restarts its period.
+static void test_timers_around_sleep()
+{
+    pbo_config_t cfg = pbo_get_default_config();
+    _setup(cfg, PboStateActive);
+    int id = pbo_timer_start(1000, 0, _count_timer_run);
+    CHECK(id >= 0);
+    _timer_runs = 0;
+    host_set_dormant_hook(_sleep_1h);
+    _request_defer(PboDeferredSleep, 0);
+    pbo_process();
+    CHECK_EQ(host_dormant_count(), 1u);
+    CHECK_EQ(_alarm_us, UINT64_MAX); // woken by the Power switch only
+    CHECK_EQ(_timer_runs, 0u);
+    _run_ms(1000);
+    CHECK_EQ(_timer_runs, 1u); // fell behind in dormant (RP2350) or due by now: one run
+    CHECK(pbo_timer_next_due_ms() <= 1000);
+    _run_ms(1000);
+    CHECK_EQ(_timer_runs, 2u);
+    pbo_timer_stop(id);
+    host_set_dormant_hook(nullptr);
+}
+
+int main()
+{
+    test_bench_expire_timers();
+    test_timers_around_sleep();
+    return _test_result("test_timers");
+}
@@ -0,0 +1,218 @@
+/*------------------------------------------------------/
+/ Copyright (c) 2026, Elehobica
+/ Released under the BSD-2-Clause
+/ refer to https://opensource.org/licenses/BSD-2-Clause
+/------------------------------------------------------*/
+
+// TRANSITIONS[] dispatch: every (state, trigger) row, the boot guard, Eco and the gesture
+// mapping, and a replay of the reference transcript (transitions.txt) of the Idle / Active
+// behaviour before the table.
+
+#include <fstream>
+#include <sstream>
+
+#include "pbo_test.h"
+
+// === Table rows ==========================================================
+// Every (state, trigger) row does what its action says, and nothing else.
+static void test_transitions_dispatch()
+{
+    for (uint32_t i = 0; i < NUM_STATES * NUM_TRIGGERS; i++) {
+        const transition_t& t = TRANSITIONS[i];
+        pbo_config_t cfg = pbo_get_default_config();
+        cfg.shutdown_defer_ms = 1000;
+        _setup(cfg, (pbo_state_t) t.state);
+        _boot = true;
+        _boot_run = true; // satisfies GuardBootRun
+        _dispatch((trigger_t) t.trigger, ButtonUserDouble);
+        switch (t.action) {
+            case ActDefer:
+                CHECK_EQ(_deferred, (pbo_deferred_reason_t) t.reason);
+                CHECK_EQ(_state, (pbo_state_t) t.state);
+                break;
+            case ActEnter:
+                CHECK_EQ(_state, (pbo_state_t) t.target);
+                CHECK_EQ(_deferred, PboDeferredNone);
+                CHECK_EQ(host_gpio_output(_cfg.pin_power_keep), STATES[t.target].power_keep);
+                break;
+            case ActForward:
+                CHECK_EQ(_forwarded, 1u);
+                CHECK_EQ(_forwarded_act, ButtonUserDouble);
+                CHECK_EQ(_state, (pbo_state_t) t.state);
+                break;
+            default:
+                CHECK_EQ(_state, (pbo_state_t) t.state);
+                CHECK_EQ(_deferred, PboDeferredNone);
+                break;
+        }
+        if (t.action != ActForward) {
+            CHECK_EQ(_forwarded, 0u);
+        }
+    }
+}
+
+static void test_transitions_semantics()
+{
+    pbo_config_t cfg = pbo_get_default_config();
+
+    // boot boundary without USB: comes up running only if the switch was held
+    _setup(cfg, PboStateIdle);
+    _boot = true;
+    _boot_run = false;
+    _dispatch(TrigNoUsb);
+    CHECK_EQ(_state, PboStateIdle);
+    _boot_run = true;
+    _dispatch(TrigNoUsb);
+    CHECK_EQ(_state, PboStateActive);
+    CHECK(host_gpio_output(_cfg.pin_power_keep));
+
+    // Idle ignores power gestures and low battery; USB schedules Charging
+    _setup(cfg, PboStateIdle);
+    _dispatch(TrigSleep);
+    _dispatch(TrigShutdown);
+    _dispatch(TrigLowBattery);
+    CHECK_EQ(_deferred, PboDeferredNone);
+    _dispatch(TrigUsb);
+    CHECK_EQ(_deferred, PboDeferredCharge);
+
+    // Eco: entered from Active, left on a wake trigger; a Sleep is deferred in Eco too
+    _setup(cfg, PboStateActive);
+    _dispatch(TrigEco);
+    CHECK_EQ(_state, PboStateActiveEco);
+    _dispatch(TrigEco);
+    CHECK_EQ(_state, PboStateActiveEco);
+    _dispatch(TrigWake);
+    CHECK_EQ(_state, PboStateActive);
+    _dispatch(TrigEco);
+    _dispatch(TrigSleep);
+    CHECK_EQ(_deferred, PboDeferredSleep);
+
+    // gesture mapping: default Double = Sleep, LongLong = Shutdown, others forwarded
+    _setup(cfg, PboStateActive);
+    CHECK_EQ(_button_trigger(ButtonPowerDouble), TrigSleep);
+    CHECK_EQ(_button_trigger(ButtonPowerLongLong), TrigShutdown);
+    CHECK_EQ(_button_trigger(ButtonPowerSingle), TrigButton);
+    CHECK_EQ(_button_trigger(ButtonUserLongLong), TrigButton);
+}
+
+// === Transcript replay ===================================================
+template <size_t N>
+static int _index_of(const char* const (&names)[N], const std::string& name)
+{
+    for (size_t i = 0; i < N; i++) {
+        if (name == names[i]) {
+            return (int) i;
+        }
+    }
+    return -1;
+}
+
+// One event through the triggers pbo_process() derives from it (see pbo_process()).
+static bool _replay_event(const std::string& event, const std::string& arg)
+{
+    bool pending = (_deferred != PboDeferredNone);
+    bool running = STATES[_state].running;
+    if (event == "tick") {
+        if (!pending && !running) {
+            _dispatch(pbo_get_usb_power_detected() ? TrigUsb : TrigNoUsb);
+            _boot = false;
+        }
+    } else if (event == "button") {
+        int btn = _index_of(BUTTON_NAMES, arg);
+        if (btn < 0) {
+            return false;
+        }
+        if (pending) {
+            _dispatch(TrigWake);
+            _on_button_event((button_action_t) btn);
+        } else if (running) {
+            _dispatch(TrigWake);
+            _dispatch(_button_trigger((button_action_t) btn), (button_action_t) btn);
+        }
+    } else if (event == "low_battery") {
+        if (running) {
+            _dispatch(TrigLowBattery);
+        }
+    } else if (event == "usb") {
+        host_gpio_set_input(PIN_USB_POWER_DETECT, arg == "on");
+        _dispatch(TrigWake);
+    } else if (event == "run") {
+        _run_deferred();
+    } else if (event == "cancel") {
+        pbo_cancel_deferred();
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static void test_transitions_replay(const char* path)
+{
+    std::ifstream in(path);
+    CHECK(in.good());
+    std::string line;
+    std::string scenario;
+    uint32_t line_no = 0;
+    uint32_t events = 0;
+    while (std::getline(in, line)) {
+        line_no++;
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream ss(line);
+        std::string word;
+        ss >> word;
+        if (word == "scenario") {
+            std::string state;
+            ss >> scenario >> state;
+            bool boot_run = false;
+            bool usb = false;
+            for (std::string opt; ss >> opt;) {
+                boot_run |= (opt == "boot_run");
+                usb |= (opt == "usb");
+            }
+            int s = _index_of(STATE_NAMES, state);
+            CHECK(s >= 0);
+            _setup(pbo_get_default_config(), (pbo_state_t) s);
+            _boot = (s == PboStateIdle);
+            _boot_run = boot_run;
+            host_gpio_set_input(PIN_USB_POWER_DETECT, usb);
+            continue;
+        }
+        // <event> [arg] => <state> <callbacks>
+        std::string event = word;
+        std::string arg;
+        std::string expect_state;
+        std::string expect_log;
+        ss >> arg;
+        if (arg == "=>") {
+            arg.clear();
+        } else {
+            ss >> word; // "=>"
+        }
+        ss >> expect_state >> expect_log;
+        bool known = _replay_event(event, arg);
+        std::string log = _take_log();
+        if (log.empty()) {
+            log = "-";
+        }
+        bool ok = known && expect_state == STATE_NAMES[_state] && expect_log == log;
+        if (!ok) {
+            printf("%s:%u: %s: '%s %s' gave %s %s, expected %s %s\n", path, line_no, scenario.c_str(),
+                   event.c_str(), arg.c_str(), STATE_NAMES[_state], log.c_str(), expect_state.c_str(),
+                   expect_log.c_str());
+        }
+        CHECK(ok);
+        events++;
+    }
+    CHECK(events > 0);
+}
+
+int main(int argc, char** argv)
+{
+    const char* transcript = (argc > 1) ? argv[1] : PBO_TEST_DATA_DIR "/transitions.txt";
+    test_transitions_dispatch();
+    test_transitions_semantics();
+    test_transitions_replay(transcript);
+    return _test_result("test_transitions");
+}
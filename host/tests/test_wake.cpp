@@ -0,0 +1,61 @@
+/*------------------------------------------------------/
+/ Copyright (c) 2026, Elehobica
+/ Released under the BSD-2-Clause
+/ refer to https://opensource.org/licenses/BSD-2-Clause
+/------------------------------------------------------*/
+
+// Wake decisions: the wake cause after dormant and the clock source dormant runs from.
+
+#include "pbo_test.h"
+
+// === Wake cause ==========================================================
+static void test_select_wake_cause()
+{
+    CHECK_EQ(_select_wake_cause(false, false), WakePowerSwitch);
+    CHECK_EQ(_select_wake_cause(true, false), WakePowerSwitch);
+    CHECK_EQ(_select_wake_cause(false, true), WakeMaxSleep);
+    CHECK_EQ(_select_wake_cause(true, true), WakePowerSwitch); // a push is never a Shutdown
+}
+
+// === Dormant clock source ================================================
+// The XOSC stops in dormant: only the LPOSC keeps the AON timer (the max_sleep_ms alarm) counting.
+static uint32_t _dormant_source = HOST_DORMANT_SOURCE_NONE;
+static bool _dormant_alarm = false;
+
+static uint64_t _record_dormant(uint pin, uint64_t alarm_us)
+{
+    (void) pin;
+    _dormant_source = host_clocks()->dormant_source;
+    _dormant_alarm = (alarm_us != UINT64_MAX);
+    return _dormant_alarm ? alarm_us - host_aon_us() : 1000 * 1000;
+}
+
+static void test_dormant_clock_source()
+{
+    pbo_config_t cfg = pbo_get_default_config();
+    _setup(cfg, PboStateActive);
+    host_set_dormant_hook(_record_dormant);
+
+    _enter_dormant_and_wake(0);
+    CHECK_EQ(_dormant_source, (uint32_t) HOST_DORMANT_SOURCE_XOSC);
+    CHECK(!_dormant_alarm);
+
+    wake_cause_t cause = _enter_dormant_and_wake(60 * 1000);
+#if PICO_RP2350
+    CHECK_EQ(_dormant_source, (uint32_t) HOST_DORMANT_SOURCE_LPOSC);
+    CHECK(_dormant_alarm);
+    CHECK_EQ(cause, WakeMaxSleep);
+#else
+    CHECK_EQ(_dormant_source, (uint32_t) HOST_DORMANT_SOURCE_XOSC); // no alarm through dormant
+    CHECK(!_dormant_alarm);
+    CHECK_EQ(cause, WakePowerSwitch);
+#endif
+    host_set_dormant_hook(nullptr);
+}
+
+int main()
+{
+    test_select_wake_cause();
+    test_dormant_clock_source();
+    return _test_result("test_wake");
+}
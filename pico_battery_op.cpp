@@ -7,10 +7,16 @@
 #include "pico_battery_op.h"
 
 #include "hardware/adc.h"
+#include "hardware/clocks.h"
 #include "hardware/gpio.h"
+#include "hardware/pll.h"
 #include "hardware/regs/io_bank0.h"
 #include "hardware/sync.h"
 #include "hardware/watchdog.h"
+#if PICO_RP2350
+#include "hardware/powman.h"
+#include "pico/aon_timer.h"
+#endif
 #include "pico/stdlib.h"
 #if defined(ARDUINO)
 // The Arduino core does not ship pico-extras, so the pico_sleep sources are vendored into this
@@ -18,8 +24,10 @@
 // that bundles the same pico-extras sources; map them back to the SDK names used below.
 #include "pbo_vendor/pbo_sleep.h"
 #define sleep_run_from_xosc          pbov_sleep_run_from_xosc
+#define sleep_run_from_lposc         pbov_sleep_run_from_lposc
 #define sleep_goto_dormant_until_pin pbov_sleep_goto_dormant_until_pin
 #define sleep_power_up               pbov_sleep_power_up
+#define sleep_goto_dormant_until     pbov_sleep_goto_dormant_until
 #else
 #include "pico/sleep.h"
 #endif
@@ -40,7 +48,22 @@
 #define pbo_dprintf(...) ((void)0)
 #endif
 
+// Trace record. Enabled only when PBO_TRACE is defined; unlike pbo_dprintf it is cheap
+// enough for the sampler ISR (see pbo_trace_read()). Otherwise it compiles to nothing.
+#ifdef PBO_TRACE
+#include <cstdio>
+#define pbo_trace(event, arg) _trace_record(event, (uint32_t) (arg))
+#else
+#define pbo_trace(event, arg) ((void)0)
+#endif
+
 // === Internal types (not exposed to the application) ===
+// What ended a dormant period (see _select_wake_cause()).
+typedef enum _wake_cause_t {
+    WakePowerSwitch = 0,
+    WakeMaxSleep           // pbo_config_t::max_sleep_ms expired
+} wake_cause_t;
+
 // Raw switch status used by the button-gesture classifier.
 typedef enum _button_status_t {
     ButtonOpen = 0,
@@ -73,17 +96,39 @@ static const uint32_t ADC_PIN_BATT_LVL = 3;  // ADC3
 static const uint32_t ADC_RESOLUTION = 12;   // 12-bit ADC (raw range 0 .. 2^12-1)
 static const float ADC_REF_VOLTAGE = 3.3;    // [V] ADC reference voltage
 
+// On-chip temperature sensor (RP2040 / RP2350 datasheet): T = 27 - (Vbe - 0.706) / 0.001721
+static const uint32_t ADC_INPUT_TEMP = ADC_TEMPERATURE_CHANNEL_NUM; // ADC4 (ADC8 on RP2350B)
+static const float TEMP_SENSOR_VBE_27C = 0.706;  // [V] at 27 degC
+static const float TEMP_SENSOR_SLOPE = 0.001721; // [V/degC]
+
 // ADC Timer & frequency for Battery monitor
 static repeating_timer_t timer;
 const int TIMER_ADC_HZ = 20;
-const int BATT_CHECK_INTERVAL_SEC = 5;
+static const uint32_t TIMER_ADC_TICK_MS = 1000 / TIMER_ADC_HZ;
+static const uint32_t DEFAULT_BATT_CHECK_MS = 5000;
+static const float DEFAULT_BATT_CHECK_MARGIN_V = 0.1; // [V]
+static const float DEFAULT_LEVEL_HYSTERESIS_V = 0.05; // [V]
+// Samples wanted before the margin is reached at the observed discharge rate
+static const float BATT_CHECK_SAMPLES_TO_MARGIN = 4.0f;
+// Conversions of the burst measurement at pbo_init() and after each wake (min / max dropped)
+static const uint32_t BATT_BURST_SAMPLES = 8;
 
 // Battery voltage
-// Initial placeholder held until the first ADC sample (~5 s after boot). It must
-// stay above DEFAULT_LOW_BATTERY_THRESHOLD so the low-battery latch does not
+// Initial placeholder held until the burst measurement in pbo_init(). It must
+// stay above DEFAULT_LOW_BATTERY_THRESHOLD so the battery level does not
 // false-trigger before a real measurement (Li-ion nominal full charge).
 static const float DEFAULT_BATT_VOLTAGE = 4.2; // [V]
 static float _bat_volt = DEFAULT_BATT_VOLTAGE; // [V]
+static const float DEFAULT_DIE_TEMPERATURE = 27.0; // [degC] placeholder until the first sample
+static float _die_temp = DEFAULT_DIE_TEMPERATURE; // [degC]
+
+// Adaptive battery sampling (sampler ticks; see pbo_config_t::batt_check_*)
+static uint32_t _batt_wait_ticks = DEFAULT_BATT_CHECK_MS / TIMER_ADC_TICK_MS; // until the next sample
+static uint32_t _batt_ticks_since = 0;   // since the last sample
+static float _batt_prev_volt = DEFAULT_BATT_VOLTAGE; // [V] at the last sample
+static float _batt_drop_rate = 0.0f;     // filtered discharge rate [V/s], 0 = unknown / charging
+// Battery level (see pbo_config_t::battery_levels); battery_levels_num + 1 = low battery
+static uint32_t _batt_level = 0;
 
 // Default battery monitor parameters (see pbo_config_t).
 // ADC3 pin is connected to middle point of voltage divider 200Kohm + 100Kohm.
@@ -102,6 +147,11 @@ static const uint32_t RELEASE_IGNORE_COUNT = 8;
 static const uint32_t LONG_PUSH_COUNT = 20;      // 20 ticks / 20 Hz = 1 s
 static const uint32_t LONG_LONG_PUSH_COUNT = 40; // 40 ticks / 20 Hz = 2 s
 
+// Enabled gestures per switch (pbo_config_t::power_gestures / user_gestures, plus the
+// POWER gestures mapped to a power action), set by pbo_init()
+static uint32_t _power_gestures = PBO_GESTURE_ALL;
+static uint32_t _user_gestures = PBO_GESTURE_ALL;
+
 static const uint32_t NUM_BTN_HISTORY = 30;
 static button_status_t button_prv[NUM_BTN_HISTORY] = {}; // initialized as HP_BUTTON_OPEN
 static uint32_t button_repeat_count = LONG_LONG_PUSH_COUNT + 1; // to ignore first buttton press when power-on
@@ -118,22 +168,197 @@ static pbo_config_t _cfg = pbo_get_default_config();
 static pbo_callbacks_t _cb = {};
 static pbo_state_t _state = PboStateIdle;
 static pbo_state_t _state_prev = PboStateIdle;
-static absolute_time_t _state_entered_at;
+static uint64_t _state_entered_ms = 0; // wall time (see _now_ms())
+// Dormant time added back to the system timer, which stops while dormant (see pbo_get_wall_time_ms())
+static uint64_t _dormant_total_ms = 0;
+// Running time before a deep Sleep power-down, carried into the wall time after the resume
+static uint64_t _wall_base_ms = 0;
 static bool _boot = false; // true while the initial (boot) PboStateIdle is unresolved
 static bool _boot_run = false; // whether to come up running at boot (set in pbo_init, applied by pbo_process)
 static pbo_deferred_reason_t _deferred = PboDeferredNone;
 static absolute_time_t _defer_deadline;
+static pbo_deferred_reason_t _deferred_queued = PboDeferredNone; // waits behind _deferred
+static uint32_t _deferred_queued_ms = 0;
+// Inactivity timers (see pbo_config_t::idle_*_ms): deadlines count from the last activity.
+static absolute_time_t _activity_at;
+static bool _idle_sleep_fired = false;    // fire once per inactivity period
+static bool _idle_shutdown_fired = false;
+static bool _idle_eco_fired = false;
+// PboStateActiveEco requests / exits, taken by the next pbo_process()
+static bool _eco_requested = false;
+static bool _activity_notified = false;
+static bool _usb_seen = false; // USB power level last seen by pbo_process()
+
+// Deep Sleep (RP2350 POWMAN power-down, see pbo_config_t::deep_sleep)
+// The switched core (CPU, SRAM, system clocks) is powered off, so the minimal library state is
+// kept in the always-on POWMAN scratch registers and the chip wakes through reset. Pads keep
+// their level through the power-down (pad isolation), so POWER_KEEP stays held.
+// The 8 scratch words also carry the statistics, in whole seconds (see _retained_stats_save()).
+// Only a Sleep writes the record, so the state it resumes is always PboStateActive.
+static const uint32_t RETAINED_MAGIC = 0x50424f02; // "PBO" + record version
+static const uint32_t NUM_RETAINED_WORDS = 8;
+typedef struct _retained_t {
+    uint32_t magic;
+    uint32_t pins;        // pin_power_keep | pin_power_sw << 8, to validate against the new config
+    uint32_t down_at_ms;  // POWMAN timer [ms, low 32 bits] at the power-down
+    // pbo_stats_t at the power-down [s]; idle_s and the counts are kept in 16 bits (saturated)
+    uint32_t idle_s;
+    uint32_t active_s;
+    uint32_t active_psm_s;
+    uint32_t sleep_s;
+    uint32_t charging_s;
+    uint32_t sleep_count;
+    uint32_t charging_count;
+} retained_t;
+static bool _resumed = false; // this boot is the wake-up from a deep Sleep
+
+// Peripheral power domains (see pbo_domain_register())
+static pbo_domain_t _domains[PBO_MAX_DOMAINS];
+static uint32_t _num_domains = 0;
+static bool _domains_up = false;
+
+// Software timers (see pbo_timer_start()); a timer is running while cb is set
+typedef struct _sw_timer_t {
+    pbo_timer_cb_t cb;
+    uint32_t period_ms;
+    uint32_t slack_ms;
+    uint64_t due_ms;      // start of the expiry window, ms since boot
+} sw_timer_t;
+static sw_timer_t _timers[PBO_MAX_TIMERS] = {};
+
+// Power-mode residency statistics (see pbo_stats_t)
+static pbo_stats_t _stats = {};
+static absolute_time_t _stats_at; // running time is accounted up to here
+
+#ifdef PBO_TRACE
+// Trace ring (power of 2 so the index wraps with a mask)
+static const uint32_t TRACE_DEPTH = 64;
+static pbo_trace_record_t _trace_ring[TRACE_DEPTH];
+static volatile uint32_t _trace_head = 0; // total records written
+static uint32_t _trace_tail = 0;          // total records read
+#endif
 
 // =========================================================================
 // Internal (static) functions
 // =========================================================================
 
+// Tell a max_sleep_ms expiry from a Power switch wake. The switch wins when both happened
+// (the user is pushing it right now), so a push is never turned into a Shutdown.
+static wake_cause_t _select_wake_cause(bool sw_pressed, bool alarm_reached)
+{
+    return (!sw_pressed && alarm_reached) ? WakeMaxSleep : WakePowerSwitch;
+}
+
+#ifdef PBO_TRACE
+// Called from both the sampler ISR and the main loop: the slot is claimed with interrupts
+// off so a main-loop record cannot be torn by the ISR.
+static void _trace_record(pbo_trace_event_t event, uint32_t arg)
+{
+    uint32_t ints = save_and_disable_interrupts();
+    pbo_trace_record_t* rec = &_trace_ring[_trace_head & (TRACE_DEPTH - 1)];
+    rec->timestamp_us = time_us_32();
+    rec->event = event;
+    rec->arg = arg;
+    _trace_head = _trace_head + 1;
+    restore_interrupts(ints);
+}
+#endif
+
+#if !defined(ARDUINO)
+static bool _stdio_usb_up = false;
+static bool _usb_clocks_on = true;            // boot / sleep_power_up() leave them running
+static volatile bool _usb_power_changed = false; // VBUS edge seen by _usb_power_irq()
+
+// clk_usb stopped, clk_adc (and on RP2040 clk_rtc) from the XOSC (slower conversions, same
+// accuracy), PLL_USB off
+static void _usb_clocks_down()
+{
+    if (!_usb_clocks_on) {
+        return;
+    }
+    // the sampler ISR must not start a conversion while clk_adc is switched
+    uint32_t ints = save_and_disable_interrupts();
+    clock_stop(clk_usb);
+    clock_configure(clk_adc, 0, CLOCKS_CLK_ADC_CTRL_AUXSRC_VALUE_XOSC_CLKSRC, XOSC_HZ, XOSC_HZ);
+#if PICO_RP2040
+    // the RTC also runs from PLL_USB; XOSC / 256 keeps its 46875 Hz
+    clock_configure(clk_rtc, 0, CLOCKS_CLK_RTC_CTRL_AUXSRC_VALUE_XOSC_CLKSRC, XOSC_HZ, XOSC_HZ / 256);
+#endif
+    pll_deinit(pll_usb);
+    restore_interrupts(ints);
+    _usb_clocks_on = false;
+}
+
+// PLL_USB, clk_usb, clk_adc and clk_rtc back to their boot configuration
+static void _usb_clocks_up()
+{
+    if (_usb_clocks_on) {
+        return;
+    }
+    uint32_t ints = save_and_disable_interrupts();
+    pll_init(pll_usb, PLL_USB_REFDIV, PLL_USB_VCO_FREQ_HZ, PLL_USB_POSTDIV1, PLL_USB_POSTDIV2);
+    clock_configure(clk_usb, 0, CLOCKS_CLK_USB_CTRL_AUXSRC_VALUE_CLKSRC_PLL_USB, USB_CLK_HZ, USB_CLK_HZ);
+    clock_configure(clk_adc, 0, CLOCKS_CLK_ADC_CTRL_AUXSRC_VALUE_CLKSRC_PLL_USB, USB_CLK_HZ, USB_CLK_HZ);
+#if PICO_RP2040
+    clock_configure(clk_rtc, 0, CLOCKS_CLK_RTC_CTRL_AUXSRC_VALUE_CLKSRC_PLL_USB, USB_CLK_HZ, RTC_CLOCK_FREQ_HZ);
+#endif
+    restore_interrupts(ints);
+    _usb_clocks_on = true;
+}
+
+static void _usb_power_irq()
+{
+    uint32_t events = gpio_get_irq_event_mask(PIN_USB_POWER_DETECT) & (GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL);
+    if (events) {
+        gpio_acknowledge_irq(PIN_USB_POWER_DETECT, events);
+        _usb_power_changed = true;
+    }
+}
+#endif
+
+// Make the USB clock domain and USB stdio (PboStdioUsb / PboStdioUartUsb only) follow USB
+// power, so neither runs while VBUS is absent. Called at start-up and after each wake, and
+// from pbo_process() after a VBUS edge.
+static void _update_usb_serial()
+{
+#if !defined(ARDUINO)
+    bool vbus = gpio_get(PIN_USB_POWER_DETECT);
+    bool usb_stdio = (_cfg.stdio == PboStdioUsb || _cfg.stdio == PboStdioUartUsb);
+    if (vbus) {
+        _usb_clocks_up(); // before enumeration
+        if (usb_stdio && !_stdio_usb_up) {
+            _stdio_usb_up = stdio_usb_init(); // don't call multiple times without stdio_usb_deinit because of duplicated IRQ calls
+        }
+    } else {
+        if (_stdio_usb_up) {
+            stdio_usb_deinit();
+            _stdio_usb_up = false;
+        }
+        if (_cfg.usb_clock_gating) {
+            _usb_clocks_down();
+        }
+    }
+#endif
+}
+
+static void _stop_usb_serial()
+{
+#if !defined(ARDUINO)
+    if (_stdio_usb_up) {
+        stdio_usb_deinit(); // terminate usb cdc
+        _stdio_usb_up = false;
+    }
+#endif
+}
+
 static void _start_serial()
 {
 #if !defined(ARDUINO)
-    stdio_uart_init();
-    stdio_usb_init(); // don't call multiple times without stdio_usb_deinit because of duplicated IRQ calls
+    if (_cfg.stdio == PboStdioUart || _cfg.stdio == PboStdioUartUsb) {
+        stdio_uart_init();
+    }
 #endif
+    _update_usb_serial();
 }
 
 static void _set_power_keep(bool value)
@@ -141,22 +366,205 @@ static void _set_power_keep(bool value)
     gpio_put(_cfg.pin_power_keep, value);
 }
 
-static void _monitor_battery_voltage()
+static float _adc_read_voltage(uint32_t input)
+{
+    adc_select_input(input);
+    return (float) adc_read() * ADC_REF_VOLTAGE / ((1 << ADC_RESOLUTION) - 1); // [V]
+}
+
+// Convert the battery input `samples` times and average them; from 3 samples on, the lowest
+// and highest conversions are dropped (spikes from load steps / DC/DC ripple).
+static float _adc_read_battery(uint32_t samples)
+{
+    float sum = 0.0f;
+    float lo = 0.0f;
+    float hi = 0.0f;
+    for (uint32_t i = 0; i < samples; i++) {
+        float v = _adc_read_voltage(ADC_PIN_BATT_LVL);
+        sum += v;
+        if (i == 0 || v < lo) lo = v;
+        if (i == 0 || v > hi) hi = v;
+    }
+    if (samples >= 3) {
+        return (sum - lo - hi) / (float) (samples - 2);
+    }
+    return sum / (float) samples;
+}
+
+static void _sample_battery_voltage(uint32_t samples)
 {
     // ADC calibration coefficients come from the config (see pbo_config_t / DEFAULT_BATT_CALIB_COEF_*).
-    adc_select_input(ADC_PIN_BATT_LVL);
-    float adc_voltage = (float) adc_read() * ADC_REF_VOLTAGE / ((1 << ADC_RESOLUTION) - 1); // [V]
+    // The die temperature is converted right after the battery, in the same burst. The sensor
+    // draws current while enabled, so it is on only for the burst. The first ADC4 conversion
+    // after enabling it is discarded whatever the number of battery samples: with a single one,
+    // the bias has not settled by then.
+    adc_set_temp_sensor_enabled(true);
+    float adc_voltage = _adc_read_battery(samples);
+    (void) _adc_read_voltage(ADC_INPUT_TEMP);
+    float vbe = _adc_read_voltage(ADC_INPUT_TEMP);
+    adc_set_temp_sensor_enabled(false);
     _bat_volt = adc_voltage * _cfg.batt_calib_coef_a + _cfg.batt_calib_coef_b; // [V]
-    pbo_dprintf("Battery Voltage = %f (V)\n", _bat_volt);
+    _die_temp = 27.0f - (vbe - TEMP_SENSOR_VBE_27C) / TEMP_SENSOR_SLOPE; // [degC]
+    pbo_trace(PboTraceAdcSample, _bat_volt * 1000);
 }
 
-static bool _get_low_battery()
+// Piecewise-linear pick from the compensation table (low_battery_threshold without one).
+static float _low_battery_threshold(float temp_c)
+{
+    uint32_t n = _cfg.low_battery_temp_comp_num;
+    const pbo_temp_comp_point_t* t = _cfg.low_battery_temp_comp;
+    if (n == 0) {
+        return _cfg.low_battery_threshold;
+    }
+    if (n > PBO_TEMP_COMP_MAX_POINTS) {
+        n = PBO_TEMP_COMP_MAX_POINTS;
+    }
+    if (temp_c <= t[0].temp_c) {
+        return t[0].threshold_v;
+    }
+    for (uint32_t i = 1; i < n; i++) {
+        if (temp_c < t[i].temp_c) {
+            float r = (temp_c - t[i - 1].temp_c) / (t[i].temp_c - t[i - 1].temp_c);
+            return t[i - 1].threshold_v + r * (t[i].threshold_v - t[i - 1].threshold_v);
+        }
+    }
+    return t[n - 1].threshold_v;
+}
+
+static uint32_t _battery_levels_num()
+{
+    return (_cfg.battery_levels_num < PBO_MAX_BATTERY_LEVELS) ? _cfg.battery_levels_num : PBO_MAX_BATTERY_LEVELS;
+}
+
+// Threshold below which level i + 1 begins; the last one is the low-battery threshold.
+static float _battery_level_threshold(uint32_t i)
+{
+    return (i < _battery_levels_num()) ? _cfg.battery_levels[i] : _low_battery_threshold(_die_temp);
+}
+
+// Threshold the next downward crossing hits: the highest one below the battery voltage.
+static float _battery_next_threshold()
+{
+    uint32_t n = _battery_levels_num();
+    float next = _battery_level_threshold(n);
+    for (uint32_t i = 0; i < n; i++) {
+        float t = _cfg.battery_levels[i];
+        if (t < _bat_volt && t > next) {
+            next = t;
+        }
+    }
+    return next;
+}
+
+static uint32_t _ms_to_ticks(uint32_t ms)
+{
+    return (ms < TIMER_ADC_TICK_MS) ? 1 : ms / TIMER_ADC_TICK_MS;
+}
+
+// Ticks until the next battery sample: batt_check_max_ms at full charge, shrinking linearly
+// with the headroom down to batt_check_min_ms at the margin, and short enough to take
+// BATT_CHECK_SAMPLES_TO_MARGIN samples before the margin at the observed discharge rate.
+// Margin and rate cap are taken against the next level threshold, so every level crossing
+// is sampled as densely as the cutoff.
+static uint32_t _batt_interval_ticks()
+{
+    uint32_t min_ticks = _ms_to_ticks(_cfg.batt_check_min_ms);
+    uint32_t max_ticks = _ms_to_ticks(_cfg.batt_check_max_ms);
+    if (max_ticks <= min_ticks) {
+        return min_ticks;
+    }
+    float threshold = _low_battery_threshold(_die_temp);
+    float above_margin = _bat_volt - threshold - _cfg.batt_check_margin_v; // [V]
+    float full_span = DEFAULT_BATT_VOLTAGE - threshold - _cfg.batt_check_margin_v; // [V]
+    if (above_margin <= 0.0f || full_span <= 0.0f) {
+        return min_ticks;
+    }
+    float above_next = _bat_volt - _battery_next_threshold() - _cfg.batt_check_margin_v; // [V]
+    if (above_next <= 0.0f) {
+        return min_ticks;
+    }
+    float r = (above_margin < full_span) ? above_margin / full_span : 1.0f;
+    float ticks = (float) min_ticks + r * (float) (max_ticks - min_ticks);
+    if (_batt_drop_rate > 0.0f) {
+        float to_margin = above_next / _batt_drop_rate * TIMER_ADC_HZ / BATT_CHECK_SAMPLES_TO_MARGIN;
+        if (to_margin < ticks) {
+            ticks = to_margin;
+        }
+    }
+    return (ticks > (float) min_ticks) ? (uint32_t) ticks : min_ticks;
+}
+
+// Periodic sample (sampler ISR, when _batt_wait_ticks runs out), then schedule the next one.
+static void _monitor_battery_voltage()
 {
-    static bool low_battery = false; // never turn to false once true
-    if (!low_battery && _bat_volt < _cfg.low_battery_threshold) {
-        low_battery = true;
+    _sample_battery_voltage(1);
+    if (_batt_ticks_since > 0) {
+        float rate = (_batt_prev_volt - _bat_volt) * TIMER_ADC_HZ / (float) _batt_ticks_since; // [V/s]
+        _batt_drop_rate = (rate > 0.0f) ? (_batt_drop_rate * 3.0f + rate) / 4.0f : 0.0f;
     }
-    return low_battery;
+    _batt_prev_volt = _bat_volt;
+    _batt_ticks_since = 0;
+    _batt_wait_ticks = _batt_interval_ticks();
+}
+
+// Filtered burst: the stored value is a placeholder (boot) or stale (after a long dormant).
+// Call with interrupts disabled or before the sampler runs, so it does not interleave with
+// the ISR's conversions. The discharge rate restarts from it; a pending sample is brought
+// forward if the fresh value calls for a shorter interval.
+static void _measure_battery_burst()
+{
+    _sample_battery_voltage(BATT_BURST_SAMPLES);
+    _batt_prev_volt = _bat_volt;
+    _batt_drop_rate = 0.0f;
+    _batt_ticks_since = 0;
+    uint32_t interval = _batt_interval_ticks();
+    if (interval < _batt_wait_ticks) {
+        _batt_wait_ticks = interval;
+    }
+}
+
+// Level of the last sample as seen from the current level: a threshold is crossed downward as
+// soon as the voltage is below it, upward only once it is battery_level_hysteresis_v above it.
+static uint32_t _battery_level_from(uint32_t level)
+{
+    uint32_t down = 0;
+    uint32_t up = 0;
+    for (uint32_t i = 0; i <= _battery_levels_num(); i++) {
+        float t = _battery_level_threshold(i);
+        if (_bat_volt < t) {
+            down++;
+        }
+        if (_bat_volt < t + _cfg.battery_level_hysteresis_v) {
+            up++;
+        }
+    }
+    if (down > level) {
+        return down;
+    } else if (up < level) {
+        return up;
+    }
+    return level;
+}
+
+// Track the level of the latest sample (pbo_process() context) and report a change.
+static void _update_battery_level()
+{
+    uint32_t level = _battery_level_from(_batt_level);
+    if (level == _batt_level) {
+        return;
+    }
+    uint32_t prev = _batt_level;
+    _batt_level = level;
+    pbo_trace(PboTraceBatteryLevel, level | (prev << 8));
+    if (_cb.on_battery_level != nullptr) {
+        _cb.on_battery_level(level, prev);
+    }
+}
+
+// The last level: below the low-battery threshold (left only with the hysteresis, e.g. charging).
+static bool _get_low_battery()
+{
+    return _batt_level > _battery_levels_num();
 }
 
 static button_status_t _get_sw_status()
@@ -174,7 +582,7 @@ static button_status_t _get_sw_status()
 
 static int _count_clicks(button_status_t target_status)
 {
-    int i;
+    uint32_t i;
     int detected_fall = 0;
     int count = 0;
     for (i = 0; i < 4; i++) {
@@ -196,21 +604,68 @@ static int _count_clicks(button_status_t target_status)
     return count;
 }
 
+static uint32_t _gestures_of(button_status_t target_status)
+{
+    return (target_status == ButtonPower) ? _power_gestures : _user_gestures;
+}
+
+// Most clicks the enabled gestures of the switch can use (1 without Double / Triple)
+static int _max_clicks(button_status_t target_status)
+{
+    uint32_t gestures = _gestures_of(target_status);
+    return (gestures & PBO_GESTURE_TRIPLE) ? 3 : (gestures & PBO_GESTURE_DOUBLE) ? 2 : 1;
+}
+
+// Single can fire on press when nothing a press may still turn into is enabled
+static bool _single_on_press(button_status_t target_status)
+{
+    uint32_t gestures = _gestures_of(target_status);
+    return (gestures & (PBO_GESTURE_DOUBLE | PBO_GESTURE_TRIPLE | PBO_GESTURE_LONG | PBO_GESTURE_LONGLONG)) == 0;
+}
+
+// Presses of target_status still in the history (those not yet consumed as clicks)
+static int _count_presses(button_status_t target_status)
+{
+    int count = 0;
+    for (uint32_t i = 0; i < NUM_BTN_HISTORY - 1; i++) {
+        if (button_prv[i] == target_status && button_prv[i+1] == ButtonOpen) {
+            count++;
+        }
+    }
+    return count;
+}
+
+static uint32_t _gesture_bit(button_action_t button_action)
+{
+    switch (button_action) {
+        case ButtonPowerSingle:   case ButtonUserSingle:   return PBO_GESTURE_SINGLE;
+        case ButtonPowerDouble:   case ButtonUserDouble:   return PBO_GESTURE_DOUBLE;
+        case ButtonPowerTriple:   case ButtonUserTriple:   return PBO_GESTURE_TRIPLE;
+        case ButtonPowerLong:     case ButtonUserLong:     return PBO_GESTURE_LONG;
+        case ButtonPowerLongLong: case ButtonUserLongLong: return PBO_GESTURE_LONGLONG;
+        default:                                           return 0;
+    }
+}
+
 static void _trigger_event(button_action_t button_action)
 {
+    button_status_t sw = (button_action <= ButtonPowerLongLong) ? ButtonPower : ButtonUser;
+    if ((_gestures_of(sw) & _gesture_bit(button_action)) == 0) {
+        return; // gesture disabled
+    }
     element_t element = {
         .button_action = button_action
     };
     if (!queue_try_add(&btn_evt_queue, &element)) {
-        pbo_dprintf("FIFO was full\n");
+        pbo_trace(PboTraceButtonDropped, button_action);
+        return;
     }
-    pbo_dprintf("trigger_event: %d\n", static_cast<int>(button_action));
-    return;
+    pbo_trace(PboTraceButton, button_action);
 }
 
 static void _update_button_action()
 {
-    int i;
+    uint32_t i;
     button_status_t button = _get_sw_status();
     if (button == ButtonOpen) {
         // Ignore button release after long push
@@ -221,8 +676,17 @@ static void _update_button_action()
             button = ButtonOpen;
         }
         button_repeat_count = 0;
-        if (button_prv[RELEASE_IGNORE_COUNT] == ButtonPower) { // Power Switch release
-            int center_clicks = _count_clicks(ButtonPower); // must be called once per tick because button_prv[] status has changed
+        button_status_t released = button_prv[RELEASE_IGNORE_COUNT];
+        int center_clicks = 0;
+        if (button_prv[0] != ButtonOpen && _count_presses(button_prv[0]) >= _max_clicks(button_prv[0])) {
+            // Released the last click the enabled gestures can use: no need to wait for more
+            released = button_prv[0];
+            center_clicks = _count_presses(released);
+            for (i = 0; i < NUM_BTN_HISTORY; i++) button_prv[i] = ButtonOpen;
+        } else if (released != ButtonOpen) {
+            center_clicks = _count_clicks(released); // must be called once per tick because button_prv[] status has changed
+        }
+        if (released == ButtonPower) { // Power Switch release
             switch (center_clicks) {
                 case 1:
                     _trigger_event(ButtonPowerSingle);
@@ -236,8 +700,7 @@ static void _update_button_action()
                 default:
                     break;
             }
-        } else if (button_prv[RELEASE_IGNORE_COUNT] == ButtonUser) { // User Switch release
-            int center_clicks = _count_clicks(ButtonUser); // must be called once per tick because button_prv[] status has changed
+        } else if (released == ButtonUser) { // User Switch release
             switch (center_clicks) {
                 case 1:
                     _trigger_event(ButtonUserSingle);
@@ -252,6 +715,10 @@ static void _update_button_action()
                     break;
             }
         }
+    } else if (button_repeat_count == 0 && button_prv[0] == ButtonOpen && _single_on_press(button)) {
+        // Nothing but Single enabled: fire on press, then ignore this press until release
+        _trigger_event((button == ButtonPower) ? ButtonPowerSingle : ButtonUserSingle);
+        button_repeat_count = LONG_LONG_PUSH_COUNT + 1;
     } else if (button_repeat_count == LONG_PUSH_COUNT) { // long push
         if (button == ButtonPower) {
             _trigger_event(ButtonPowerLong);
@@ -271,8 +738,8 @@ static void _update_button_action()
         button_repeat_count++;
     }
     // Button status shift
-    for (i = NUM_BTN_HISTORY-2; i >= 0; i--) {
-        button_prv[i+1] = button_prv[i];
+    for (i = NUM_BTN_HISTORY-1; i > 0; i--) {
+        button_prv[i] = button_prv[i-1];
     }
     button_prv[0] = button;
 }
@@ -282,7 +749,7 @@ static void _update_button_action()
 // whose release must not be recognized as a button gesture).
 static void _reset_button_state()
 {
-    for (int i = 0; i < NUM_BTN_HISTORY; i++) {
+    for (uint32_t i = 0; i < NUM_BTN_HISTORY; i++) {
         button_prv[i] = ButtonOpen;
     }
     button_repeat_count = LONG_LONG_PUSH_COUNT + 1; // ignore the ongoing press until release
@@ -292,12 +759,12 @@ static void _reset_button_state()
 }
 
 static bool _timer_callback_adc(repeating_timer_t* rt) {
-    static int count = 0;
+    (void) rt;
     _update_button_action();
-    if (count % (TIMER_ADC_HZ * BATT_CHECK_INTERVAL_SEC) == TIMER_ADC_HZ * BATT_CHECK_INTERVAL_SEC - 1) {
+    _batt_ticks_since++;
+    if (--_batt_wait_ticks == 0) {
         _monitor_battery_voltage();
     }
-    count++;
     return true; // keep repeating
 }
 
@@ -337,31 +804,65 @@ static void _clear_btn_evt()
     */
 }
 
-static void _enter_dormant_and_wake()
+#if PICO_RP2350
+// The alarm only has to end dormant; the wake cause is read back from the clock.
+static void _on_max_sleep_alarm()
+{
+}
+#endif
+
+static wake_cause_t _enter_dormant_and_wake(uint32_t max_ms)
 {
     // === [1] Preparation for dormant ===
     bool psm = gpio_get(PIN_DCDC_PSM_CTRL);
     gpio_put(PIN_DCDC_PSM_CTRL, 0); // PFM mode for better efficiency
-#if !defined(ARDUINO)
-    stdio_usb_deinit(); // terminate usb cdc
-#endif
+    _stop_usb_serial();
 
     // === [2] goto dormant then wake up ===
-    // Clock preserve/restore is handled by the Pico SDK: sleep_run_from_xosc() switches the
-    // clocks to the dormant source and sleep_power_up() restores them on wake. This replaces
-    // the formerly ported 'recover_from_sleep' block and matches the pico-extras
-    // 'hello_dormant' example.
+    // Clock preserve/restore is handled by the Pico SDK: sleep_run_from_xosc() /
+    // sleep_run_from_lposc() switch the clocks to the dormant source and sleep_power_up()
+    // restores them on wake. This replaces the formerly ported 'recover_from_sleep' block and
+    // matches the pico-extras 'hello_dormant' example.
     uint32_t ints = save_and_disable_interrupts(); // (+a)
-    sleep_run_from_xosc();
-    // go to dormant until the Power switch is pushed (fall edge detected)
-    sleep_goto_dormant_until_pin(_cfg.pin_power_sw, true, false);
+    bool alarm_reached = false;
+#if PICO_RP2350
+    if (max_ms != 0) {
+        // go to dormant until the Power switch is pushed or the AON timer alarm expires:
+        // arm the pin as a dormant wake source, then let the SDK go dormant on the alarm.
+        // The XOSC stops in dormant, so the AON timer has to keep counting on the LPOSC.
+        sleep_run_from_lposc();
+        struct timespec ts;
+        aon_timer_get_time(&ts);
+        uint64_t wake_at_ms = (uint64_t) ts.tv_sec * 1000 + (uint64_t) ts.tv_nsec / 1000000 + max_ms;
+        ts.tv_sec = (time_t) (wake_at_ms / 1000);
+        ts.tv_nsec = (long) (wake_at_ms % 1000) * 1000000;
+        gpio_set_dormant_irq_enabled(_cfg.pin_power_sw, GPIO_IRQ_EDGE_FALL, true);
+        sleep_goto_dormant_until(&ts, _on_max_sleep_alarm);
+        gpio_set_dormant_irq_enabled(_cfg.pin_power_sw, GPIO_IRQ_EDGE_FALL, false);
+        gpio_acknowledge_irq(_cfg.pin_power_sw, GPIO_IRQ_EDGE_FALL);
+        aon_timer_disable_alarm();
+        struct timespec now;
+        aon_timer_get_time(&now);
+        alarm_reached = ((uint64_t) now.tv_sec * 1000 + (uint64_t) now.tv_nsec / 1000000) >= wake_at_ms;
+    } else
+#endif
+    {
+        // go to dormant until the Power switch is pushed (fall edge detected)
+        (void) max_ms;
+        sleep_run_from_xosc();
+        sleep_goto_dormant_until_pin(_cfg.pin_power_sw, true, false);
+    }
 
     // ---------------
     // --- Dormant ---
     // ---------------
 
-    // wake up from here (Power switch push)
+    // wake up from here (Power switch push or max_sleep_ms alarm)
     sleep_power_up(); // restore clocks / oscillators after dormant
+#if !defined(ARDUINO)
+    _usb_clocks_on = true; // all clocks are back at their boot configuration
+#endif
+    _measure_battery_burst(); // fresh value before anything is powered up again
     restore_interrupts(ints); // (-a)
 
     // === [3] treatments after wake up ===
@@ -374,21 +875,337 @@ static void _enter_dormant_and_wake()
     // Ignore the wake-up Power switch push (and its release) so it is not recognized
     // as a button gesture (e.g. ButtonPowerSingle would re-enter dormant immediately).
     _reset_button_state();
+
+    return _select_wake_cause(gpio_get(_cfg.pin_power_sw) == false, alarm_reached);
+}
+
+#if PICO_RP2350
+// Retained state record <-> words. Kept free of hardware access so the save/restore and the
+// resume decision are plain functions of their inputs.
+static uint32_t _sat16(uint32_t value)
+{
+    return (value < 0xffff) ? value : 0xffff;
+}
+
+static void _retained_pack(const retained_t* rec, uint32_t* words)
+{
+    words[0] = rec->magic;
+    words[1] = (rec->pins & 0xffff) | (_sat16(rec->sleep_count) << 16);
+    words[2] = rec->down_at_ms;
+    words[3] = _sat16(rec->idle_s) | (_sat16(rec->charging_count) << 16);
+    words[4] = rec->active_s;
+    words[5] = rec->active_psm_s;
+    words[6] = rec->sleep_s;
+    words[7] = rec->charging_s;
+}
+
+static void _retained_unpack(const uint32_t* words, retained_t* rec)
+{
+    rec->magic = words[0];
+    rec->pins  = words[1] & 0xffff;
+    rec->sleep_count = words[1] >> 16;
+    rec->down_at_ms = words[2];
+    rec->idle_s = words[3] & 0xffff;
+    rec->charging_count = words[3] >> 16;
+    rec->active_s = words[4];
+    rec->active_psm_s = words[5];
+    rec->sleep_s = words[6];
+    rec->charging_s = words[7];
+}
+
+// Statistics <-> record, rounded to the nearest second so the error does not build up over
+// many Sleeps. slept_ms, the power-down itself, is added to sleep_ms on restore.
+static uint32_t _ms_to_s(uint64_t ms)
+{
+    uint64_t sec = (ms + 500) / 1000;
+    return (sec < UINT32_MAX) ? (uint32_t) sec : UINT32_MAX;
+}
+
+static void _retained_stats_save(const pbo_stats_t* st, retained_t* rec)
+{
+    rec->idle_s = _ms_to_s(st->idle_ms);
+    rec->active_s = _ms_to_s(st->active_ms);
+    rec->active_psm_s = _ms_to_s(st->active_psm_ms);
+    rec->sleep_s = _ms_to_s(st->sleep_ms);
+    rec->charging_s = _ms_to_s(st->charging_ms);
+    rec->sleep_count = st->sleep_count;
+    rec->charging_count = st->charging_count;
+}
+
+static void _retained_stats_restore(const retained_t* rec, uint32_t slept_ms, pbo_stats_t* st)
+{
+    st->idle_ms = (uint64_t) rec->idle_s * 1000;
+    st->active_ms = (uint64_t) rec->active_s * 1000;
+    st->active_psm_ms = (uint64_t) rec->active_psm_s * 1000;
+    st->sleep_ms = (uint64_t) rec->sleep_s * 1000 + slept_ms;
+    st->charging_ms = (uint64_t) rec->charging_s * 1000;
+    st->sleep_count = rec->sleep_count;
+    st->charging_count = rec->charging_count;
+}
+
+static uint32_t _retained_pins(const pbo_config_t* cfg)
+{
+    return (cfg->pin_power_keep & 0xff) | ((cfg->pin_power_sw & 0xff) << 8);
+}
+
+// Resume in PboStateActive only if the reset was caused by a switched-core power-down and the
+// record was left by a Sleep under the same pin assignment; anything else is a normal boot.
+static bool _select_resume(bool had_swcore_pd, const retained_t* rec, const pbo_config_t* cfg)
+{
+    return had_swcore_pd
+        && rec->magic == RETAINED_MAGIC
+        && rec->pins == _retained_pins(cfg);
+}
+
+// Read and consume the retained record (it must not survive into a later, unrelated reset).
+// *cause tells a Power switch wake from a max_sleep_ms expiry; *rec and *slept_ms (the length
+// of the power-down) are for _deep_sleep_restore_stats().
+static bool _deep_sleep_check_resume(wake_cause_t* cause, retained_t* rec, uint32_t* slept_ms)
+{
+    uint32_t words[NUM_RETAINED_WORDS];
+    for (uint32_t i = 0; i < NUM_RETAINED_WORDS; i++) {
+        words[i] = powman_hw->scratch[i];
+        powman_hw->scratch[i] = 0;
+    }
+    _retained_unpack(words, rec);
+    bool had_swcore_pd = (powman_hw->chip_reset & POWMAN_CHIP_RESET_HAD_SWCORE_PD_BITS) != 0;
+    *slept_ms = (uint32_t) powman_timer_get_ms() - rec->down_at_ms;
+    bool alarm_reached = _cfg.max_sleep_ms != 0 && *slept_ms >= _cfg.max_sleep_ms;
+    *cause = _select_wake_cause(gpio_get(_cfg.pin_power_sw) == false, alarm_reached);
+    return _select_resume(had_swcore_pd, rec, &_cfg);
+}
+
+// Carry the statistics, and with them the wall and dormant time, over the power-down. The
+// system timer restarted at the reset: the running time before it becomes _wall_base_ms.
+static void _deep_sleep_restore_stats(const retained_t* rec, uint32_t slept_ms)
+{
+    _retained_stats_restore(rec, slept_ms, &_stats);
+    _dormant_total_ms = _stats.sleep_ms + _stats.charging_ms;
+    _wall_base_ms = _stats.idle_ms + _stats.active_ms + _stats.active_psm_ms;
+    _stats_at = get_absolute_time();
+}
+
+// Power the switched core off until the Power switch is pushed. Returns only if POWMAN
+// rejected the power states, in which case the caller falls back to dormant.
+static void _deep_sleep_power_down()
+{
+    retained_t rec = {};
+    rec.magic = RETAINED_MAGIC;
+    rec.pins = _retained_pins(&_cfg);
+    rec.down_at_ms = (uint32_t) powman_timer_get_ms();
+    _retained_stats_save(&_stats, &rec); // brought up to date by _dormant_and_resume()
+    uint32_t words[NUM_RETAINED_WORDS];
+    _retained_pack(&rec, words);
+
+    powman_power_state off_state = POWMAN_POWER_STATE_NONE;
+    powman_power_state on_state = POWMAN_POWER_STATE_NONE;
+    on_state = powman_power_state_with_domain_on(on_state, POWMAN_POWER_DOMAIN_SWITCHED_CORE);
+    on_state = powman_power_state_with_domain_on(on_state, POWMAN_POWER_DOMAIN_XIP_CACHE);
+    on_state = powman_power_state_with_domain_on(on_state, POWMAN_POWER_DOMAIN_SRAM_BANK0);
+    on_state = powman_power_state_with_domain_on(on_state, POWMAN_POWER_DOMAIN_SRAM_BANK1);
+    if (!powman_configure_wakeup_state(off_state, on_state)) {
+        return;
+    }
+#if !defined(ARDUINO)
+    stdio_flush();
+#endif
+    gpio_put(PIN_DCDC_PSM_CTRL, 0); // PFM mode for better efficiency (latched by pad isolation)
+    for (uint32_t i = 0; i < NUM_RETAINED_WORDS; i++) {
+        powman_hw->scratch[i] = words[i];
+    }
+    powman_set_debug_power_request_ignored(true); // allow power-down with a debugger attached
+    // wake on the Power switch push (fall edge), then boot normally from flash
+    powman_enable_gpio_wakeup(0, _cfg.pin_power_sw, true, false);
+    if (_cfg.max_sleep_ms != 0) {
+        powman_enable_alarm_wakeup_at_ms(powman_timer_get_ms() + _cfg.max_sleep_ms);
+    }
+    for (uint32_t i = 0; i < 4; i++) {
+        powman_hw->boot[i] = 0;
+    }
+    uint32_t ints = save_and_disable_interrupts();
+    if (powman_set_power_state(off_state) != PICO_OK) {
+        for (uint32_t i = 0; i < NUM_RETAINED_WORDS; i++) {
+            powman_hw->scratch[i] = 0;
+        }
+        powman_disable_gpio_wakeup(0);
+        powman_disable_alarm_wakeup();
+        restore_interrupts(ints);
+        return;
+    }
+    while (true) {
+        __wfi(); // the switched core powers off here; wake-up is a reset
+    }
+}
+#endif // PICO_RP2350
+
+// === Statistics ==========================================================
+// Account the running time since the last update to the current state (and DC/DC mode).
+// Called on every pbo_process() and around dormant, so a mode change set by the
+// application between calls is attributed at that granularity.
+static void _stats_update()
+{
+    absolute_time_t now = get_absolute_time();
+    int64_t elapsed_us = absolute_time_diff_us(_stats_at, now);
+    if (elapsed_us < 1000) {
+        return;
+    }
+    uint64_t ms = (uint64_t) elapsed_us / 1000;
+    _stats_at = delayed_by_us(_stats_at, ms * 1000); // keep the sub-ms remainder
+    if (_state == PboStateIdle) {
+        _stats.idle_ms += ms;
+    } else if (gpio_get(PIN_DCDC_PSM_CTRL)) {
+        _stats.active_ms += ms;
+    } else {
+        _stats.active_psm_ms += ms;
+    }
+}
+
+// Milliseconds on a clock that keeps running through dormant, or 0 where there is none
+// (RP2040: the RTC and system timer both stop with the oscillators). The dormant periods then
+// measure 0, which is why pbo_estimate_runtime_hours() reports PBO_RUNTIME_UNSUPPORTED there.
+static uint64_t _dormant_clock_ms()
+{
+#if PICO_RP2350
+    struct timespec ts;
+    if (aon_timer_get_time(&ts)) {
+        return (uint64_t) ts.tv_sec * 1000 + (uint64_t) ts.tv_nsec / 1000000;
+    }
+#endif
+    return 0;
+}
+
+// Wall time [ms since boot]: the system timer plus the dormant periods it missed.
+static uint64_t _now_ms()
+{
+    return time_us_64() / 1000 + _dormant_total_ms + _wall_base_ms;
+}
+
+// === Inactivity timers ===================================================
+static void _restart_inactivity()
+{
+    _activity_at = get_absolute_time();
+    _idle_sleep_fired = false;
+    _idle_shutdown_fired = false;
+    _idle_eco_fired = false;
+}
+
+// Whether an inactivity timer of timeout_ms (0 = disabled) has reached its deadline.
+static bool _inactivity_expired(uint32_t timeout_ms)
+{
+    return timeout_ms != 0 && time_reached(delayed_by_ms(_activity_at, timeout_ms));
 }
 
 // === Power state machine =================================================
-// Enter a stable state: enforce its power-keep invariant, timestamp it and
-// notify the application. No-op if already in that state.
+// Properties of each stable state, indexed by pbo_state_t.
+typedef struct _state_desc_t {
+    bool power_keep;    // POWER_KEEP latch held
+    bool running;       // power actions, low battery and inactivity timers are evaluated
+} state_desc_t;
+
+static constexpr state_desc_t STATES[] = {
+    // power_keep  running
+    { false,       false },  // PboStateIdle
+    { true,        true  },  // PboStateActive
+    { true,        true  },  // PboStateActiveEco
+};
+static constexpr uint32_t NUM_STATES = sizeof(STATES) / sizeof(STATES[0]);
+static_assert(NUM_STATES == PboStateActiveEco + 1, "STATES[] must cover pbo_state_t");
+
+// Events pbo_process() feeds to the transition table.
+typedef enum _trigger_t {
+    TrigLowBattery = 0, // battery below the cutoff
+    TrigSleep,          // POWER gesture mapped to PboActionSleep, or idle_sleep_ms expiry
+    TrigShutdown,       // POWER gesture mapped to PboActionShutdown, or idle_shutdown_ms expiry
+    TrigButton,         // any other button event
+    TrigEco,            // idle_eco_ms expiry or pbo_request_eco()
+    TrigWake,           // button event, USB plug / unplug or pbo_notify_activity()
+    TrigUsb,            // boot boundary / shutdown with USB power
+    TrigNoUsb,          // boot boundary / shutdown without USB power
+    NUM_TRIGGERS
+} trigger_t;
+
+typedef enum _guard_t {
+    GuardNone = 0,
+    GuardBootRun,       // the power switch was held at boot, and this is the boot boundary
+} guard_t;
+
+typedef enum _sm_action_t {
+    ActNone = 0,        // ignored in this state
+    ActDefer,           // request the deferred action (reason)
+    ActEnter,           // enter the stable state (target)
+    ActForward,         // forward the button event to on_button_event()
+} sm_action_t;
+
+typedef struct _transition_t {
+    uint8_t state;      // pbo_state_t
+    uint8_t trigger;    // trigger_t
+    uint8_t guard;      // guard_t
+    uint8_t action;     // sm_action_t
+    uint8_t reason;     // pbo_deferred_reason_t (ActDefer)
+    uint8_t target;     // pbo_state_t (ActEnter)
+} transition_t;
+
+// Every (state, trigger) pair in state-major order, so dispatch is a direct index.
+static constexpr transition_t TRANSITIONS[] = {
+    // state             trigger         guard         action      reason                 target
+    { PboStateIdle,      TrigLowBattery, GuardNone,    ActNone,    PboDeferredNone,       PboStateIdle      },
+    { PboStateIdle,      TrigSleep,      GuardNone,    ActNone,    PboDeferredNone,       PboStateIdle      },
+    { PboStateIdle,      TrigShutdown,   GuardNone,    ActNone,    PboDeferredNone,       PboStateIdle      },
+    { PboStateIdle,      TrigButton,     GuardNone,    ActNone,    PboDeferredNone,       PboStateIdle      },
+    { PboStateIdle,      TrigEco,        GuardNone,    ActNone,    PboDeferredNone,       PboStateIdle      },
+    { PboStateIdle,      TrigWake,       GuardNone,    ActNone,    PboDeferredNone,       PboStateIdle      },
+    { PboStateIdle,      TrigUsb,        GuardNone,    ActDefer,   PboDeferredCharge,     PboStateIdle      },
+    { PboStateIdle,      TrigNoUsb,      GuardBootRun, ActEnter,   PboDeferredNone,       PboStateActive    },
+    { PboStateActive,    TrigLowBattery, GuardNone,    ActDefer,   PboDeferredLowBattery, PboStateActive    },
+    { PboStateActive,    TrigSleep,      GuardNone,    ActDefer,   PboDeferredSleep,      PboStateActive    },
+    { PboStateActive,    TrigShutdown,   GuardNone,    ActDefer,   PboDeferredShutdown,   PboStateActive    },
+    { PboStateActive,    TrigButton,     GuardNone,    ActForward, PboDeferredNone,       PboStateActive    },
+    { PboStateActive,    TrigEco,        GuardNone,    ActEnter,   PboDeferredNone,       PboStateActiveEco },
+    { PboStateActive,    TrigWake,       GuardNone,    ActNone,    PboDeferredNone,       PboStateActive    },
+    { PboStateActive,    TrigUsb,        GuardNone,    ActNone,    PboDeferredNone,       PboStateActive    },
+    { PboStateActive,    TrigNoUsb,      GuardNone,    ActNone,    PboDeferredNone,       PboStateActive    },
+    { PboStateActiveEco, TrigLowBattery, GuardNone,    ActDefer,   PboDeferredLowBattery, PboStateActiveEco },
+    { PboStateActiveEco, TrigSleep,      GuardNone,    ActDefer,   PboDeferredSleep,      PboStateActiveEco },
+    { PboStateActiveEco, TrigShutdown,   GuardNone,    ActDefer,   PboDeferredShutdown,   PboStateActiveEco },
+    { PboStateActiveEco, TrigButton,     GuardNone,    ActForward, PboDeferredNone,       PboStateActiveEco },
+    { PboStateActiveEco, TrigEco,        GuardNone,    ActNone,    PboDeferredNone,       PboStateActiveEco },
+    { PboStateActiveEco, TrigWake,       GuardNone,    ActEnter,   PboDeferredNone,       PboStateActive    },
+    { PboStateActiveEco, TrigUsb,        GuardNone,    ActNone,    PboDeferredNone,       PboStateActiveEco },
+    { PboStateActiveEco, TrigNoUsb,      GuardNone,    ActNone,    PboDeferredNone,       PboStateActiveEco },
+};
+
+static constexpr bool _transitions_ordered(uint32_t i)
+{
+    return i == NUM_STATES * NUM_TRIGGERS
+        || (TRANSITIONS[i].state == i / NUM_TRIGGERS && TRANSITIONS[i].trigger == i % NUM_TRIGGERS
+            && _transitions_ordered(i + 1));
+}
+static_assert(sizeof(TRANSITIONS) / sizeof(TRANSITIONS[0]) == NUM_STATES * NUM_TRIGGERS,
+              "TRANSITIONS[] must have a row for every (state, trigger)");
+static_assert(_transitions_ordered(0), "TRANSITIONS[] must be in state-major (state, trigger) order");
+
+// Enter a stable state: run the Eco hooks, enforce its power-keep invariant, timestamp it
+// and notify the application. No-op if already in that state.
 static void _set_state(pbo_state_t new_state)
 {
     if (new_state == _state) {
         return;
     }
     pbo_state_t prev = _state;
+    if (prev == PboStateActiveEco && _cb.on_exit_eco != nullptr) {
+        _cb.on_exit_eco();
+    }
     _state = new_state;
-    _state_entered_at = get_absolute_time();
-    // power-keep invariant: held while Active, released in Idle.
-    _set_power_keep(new_state == PboStateActive);
+    _state_entered_ms = _now_ms();
+    if (new_state != PboStateActiveEco) {
+        _restart_inactivity(); // Eco is entered on inactivity; the other timers keep running
+    }
+    pbo_trace(PboTraceStateChange, new_state | (prev << 8));
+    // power-keep invariant: held while running, released in Idle.
+    _set_power_keep(STATES[new_state].power_keep);
+    if (new_state == PboStateActiveEco && _cb.on_enter_eco != nullptr) {
+        _cb.on_enter_eco();
+    }
     if (_cb.on_state_changed != nullptr) {
         _cb.on_state_changed(new_state, prev);
     }
@@ -399,25 +1216,202 @@ static bool _deferred_cancelable(pbo_deferred_reason_t reason)
     return (reason == PboDeferredSleep) || (reason == PboDeferredShutdown);
 }
 
+// Priority among deferred actions: a terminal action outranks a Sleep, and low battery
+// outranks a user Shutdown (which it would also end in, but without the cancel option).
+static int _deferred_priority(pbo_deferred_reason_t reason)
+{
+    switch (reason) {
+        case PboDeferredLowBattery: return 3;
+        case PboDeferredShutdown:   return 2;
+        case PboDeferredSleep:      return 1;
+        case PboDeferredCharge:     return 1;
+        default:                    return 0;
+    }
+}
+
 static void _begin_defer(pbo_deferred_reason_t reason, uint32_t defer_ms)
 {
     _deferred = reason;
     _defer_deadline = make_timeout_time_ms(defer_ms);
+    pbo_trace(PboTraceDeferBegin, reason);
     if (_cb.on_deferred != nullptr) {
         _cb.on_deferred(reason);
     }
 }
 
+// Request a deferred action against the one already pending (see pbo_deferred_reason_t):
+//   none pending      : begin it.
+//   higher priority   : preempt the pending one (and drop a queued one it outranks). A
+//                       pending Shutdown already ends where the preempting action does, so
+//                       its remaining delay is kept when shorter than defer_ms.
+//   otherwise         : queue it behind the pending one, keeping the highest-priority
+//                       request in the single queue slot (a duplicate is ignored).
+static void _request_defer(pbo_deferred_reason_t reason, uint32_t defer_ms)
+{
+    if (_deferred == PboDeferredNone) {
+        _begin_defer(reason, defer_ms);
+        return;
+    }
+    if (reason == _deferred || reason == _deferred_queued) {
+        return;
+    }
+    if (_deferred_priority(reason) > _deferred_priority(_deferred)) {
+        pbo_deferred_reason_t preempted = _deferred;
+        pbo_trace(PboTraceDeferPreempt, reason | (preempted << 8));
+        if (_deferred_priority(_deferred_queued) <= _deferred_priority(reason)) {
+            _deferred_queued = PboDeferredNone;
+        }
+        if (preempted == PboDeferredShutdown) {
+            int64_t remaining_us = absolute_time_diff_us(get_absolute_time(), _defer_deadline);
+            uint32_t remaining_ms = (remaining_us > 0) ? (uint32_t) (remaining_us / 1000) : 0;
+            defer_ms = (remaining_ms < defer_ms) ? remaining_ms : defer_ms;
+        }
+        if (_cb.on_deferred_preempted != nullptr) {
+            _cb.on_deferred_preempted(preempted, reason);
+        }
+        _begin_defer(reason, defer_ms);
+    } else if (_deferred_priority(reason) > _deferred_priority(_deferred_queued)) {
+        pbo_trace(PboTraceDeferQueue, reason);
+        _deferred_queued = reason;
+        _deferred_queued_ms = defer_ms;
+    }
+}
+
+static void _domain_set_power(const pbo_domain_t* d, bool on)
+{
+    if (d->pin_power == PBO_PIN_UNUSED) {
+        return;
+    }
+    gpio_init(d->pin_power); // also restores a pad let go by a low-leakage sweep
+    gpio_disable_pulls(d->pin_power);
+    gpio_put(d->pin_power, on != d->power_active_low);
+    gpio_set_dir(d->pin_power, GPIO_OUT);
+}
+
+// Index of the pending domain whose settle deadline comes first (pending is non-zero). Pure
+// function of its inputs, so the bring-up order can be checked against a virtual clock.
+static uint32_t _domain_next(const uint64_t* due_us, uint32_t num, uint32_t pending)
+{
+    uint32_t next = num;
+    for (uint32_t i = 0; i < num; i++) {
+        if ((pending & (1u << i)) && (next == num || due_us[i] < due_us[next])) {
+            next = i;
+        }
+    }
+    return next;
+}
+
+static void _domains_power_down()
+{
+    if (!_domains_up) {
+        return;
+    }
+    for (uint32_t i = _num_domains; i-- > 0;) {
+        if (_domains[i].deinit != nullptr) {
+            _domains[i].deinit();
+        }
+        _domain_set_power(&_domains[i], false);
+    }
+    _domains_up = false;
+}
+
+static uint32_t _domains_hold_mask()
+{
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < _num_domains; i++) {
+        mask |= _domains[i].hold_mask;
+        if (_domains[i].pin_power != PBO_PIN_UNUSED) {
+            mask |= 1u << _domains[i].pin_power; // keep the switch driven off
+        }
+    }
+    return mask;
+}
+
+// End of the earliest expiry window: the time the next coalesced batch must run by.
+// UINT64_MAX if no timer is running.
+static uint64_t _timer_fire_at()
+{
+    uint64_t fire_at = UINT64_MAX;
+    for (uint32_t i = 0; i < PBO_MAX_TIMERS; i++) {
+        if (_timers[i].cb != nullptr && _timers[i].due_ms + _timers[i].slack_ms < fire_at) {
+            fire_at = _timers[i].due_ms + _timers[i].slack_ms;
+        }
+    }
+    return fire_at;
+}
+
+// Once the earliest window has closed, run every timer that is due by now_ms in one batch.
+static void _run_timers(uint64_t now_ms)
+{
+    if (now_ms < _timer_fire_at()) {
+        return;
+    }
+    for (uint32_t i = 0; i < PBO_MAX_TIMERS; i++) {
+        sw_timer_t* t = &_timers[i];
+        if (t->cb == nullptr || now_ms < t->due_ms) {
+            continue;
+        }
+        // next window first, so the callback may stop (or restart) its own timer
+        t->due_ms += t->period_ms;
+        if (t->due_ms <= now_ms) {
+            t->due_ms = now_ms + t->period_ms; // fell behind (e.g. dormant): no burst of catch-ups
+        }
+        t->cb();
+    }
+}
+
 // Enter dormant mode and resume running. Shared by Sleep and Charging: the power-keep latch
 // (held for Sleep, released for Charging) is already set by the current state's invariant, so
 // this touches only the callbacks.
 static void _dormant_and_resume()
 {
+    bool sleep = (_state == PboStateActive); // Sleep, otherwise Charging
+    _stats_update();
+    if (sleep) {
+        _stats.sleep_count++;
+    } else {
+        _stats.charging_count++;
+    }
+    _domains_power_down();
     if (_cb.on_enter_dormant != nullptr) {
         _cb.on_enter_dormant();
     }
-    _enter_dormant_and_wake();             // blocks until the Power switch
+#if PICO_RP2350
+    // A Sleep (PboStateActive) may power the switched core off instead; this only returns
+    // if POWMAN could not enter the power-down, in which case dormant is used as usual.
+    if (_cfg.deep_sleep && sleep) {
+        _deep_sleep_power_down();
+    }
+#endif
+    uint64_t dormant_from = _dormant_clock_ms();
+    uint64_t timer_from_us = time_us_64();
+    pbo_trace(PboTraceDormantEnter, 0);
+    // blocks until the Power switch (or, for a Sleep, max_sleep_ms)
+    wake_cause_t cause = _enter_dormant_and_wake(sleep ? _cfg.max_sleep_ms : 0);
+    pbo_trace(PboTraceDormantExit, cause);
+    uint64_t dormant_ms = _dormant_clock_ms() - dormant_from;
+    // The system timer ran only around dormant; add back what it missed.
+    uint64_t timer_ms = (time_us_64() - timer_from_us) / 1000;
+    if (dormant_ms > timer_ms) {
+        _dormant_total_ms += dormant_ms - timer_ms;
+    }
+    _restart_inactivity();                 // the wake push is activity
+    if (sleep) {
+        _stats.sleep_ms += dormant_ms;
+    } else {
+        _stats.charging_ms += dormant_ms;
+    }
+    _stats_at = get_absolute_time();       // the dormant period is not running time
+    _update_battery_level();               // from the burst measurement on wake
+    if (cause == WakeMaxSleep || _get_low_battery()) {
+        // Forgotten in Sleep, or the cell ran below the cutoff while dormant (measured on
+        // wake): shut down to hardware Stand-by (or Charging with USB) without restoring
+        // the application's peripherals.
+        _set_state(PboStateIdle);
+        return;
+    }
     _set_state(PboStateActive);             // resume running (no-op if already Active)
+    pbo_domains_power_up();
     if (_cb.on_exit_dormant != nullptr) {
         _cb.on_exit_dormant();
     }
@@ -427,8 +1421,14 @@ static void _run_deferred()
 {
     pbo_deferred_reason_t reason = _deferred;
     _deferred = PboDeferredNone;
+    _deferred_queued = PboDeferredNone; // superseded by the action that runs now
+    pbo_trace(PboTraceDeferRun, reason);
     switch (reason) {
         case PboDeferredSleep:    // enter dormant from PboStateActive (Sleep, latch held)
+            // leave Eco while the peripherals are still up; a Sleep always wakes into Active
+            _set_state(PboStateActive);
+            _dormant_and_resume();
+            break;
         case PboDeferredCharge:   // enter dormant from PboStateIdle (Charging, latch released)
             _dormant_and_resume();
             break;
@@ -442,6 +1442,74 @@ static void _run_deferred()
     }
 }
 
+// Announce delay of a deferred action (see pbo_config_t::*_defer_ms).
+static uint32_t _defer_ms(pbo_deferred_reason_t reason)
+{
+    switch (reason) {
+        case PboDeferredSleep:      return _cfg.sleep_defer_ms;
+        case PboDeferredShutdown:
+        case PboDeferredLowBattery: return _cfg.shutdown_defer_ms;
+        case PboDeferredCharge:     return _cfg.charge_defer_ms;
+        default:                    return 0;
+    }
+}
+
+static bool _guard_ok(guard_t guard)
+{
+    switch (guard) {
+        case GuardBootRun: return _boot && _boot_run;
+        case GuardNone:
+        default:           return true;
+    }
+}
+
+// Run the transition of trigger in the current state (btn_act: the event for ActForward).
+static void _dispatch(trigger_t trigger, button_action_t btn_act = ButtonOthers)
+{
+    const transition_t& t = TRANSITIONS[_state * NUM_TRIGGERS + trigger];
+    if (!_guard_ok((guard_t) t.guard)) {
+        return;
+    }
+    switch (t.action) {
+        case ActDefer:
+            _request_defer((pbo_deferred_reason_t) t.reason, _defer_ms((pbo_deferred_reason_t) t.reason));
+            break;
+        case ActEnter:
+            _set_state((pbo_state_t) t.target);
+            break;
+        case ActForward:
+            if (_cb.on_button_event != nullptr) {
+                _cb.on_button_event(btn_act);
+            }
+            break;
+        case ActNone:
+        default:
+            break;
+    }
+}
+
+// Request a Sleep / Shutdown / Eco once the inactivity timers expire (running states only).
+// While USB is present they can be held, and they restart from the unplug.
+static void _check_inactivity()
+{
+    if (_cfg.idle_suspend_on_usb && pbo_get_usb_power_detected()) {
+        _restart_inactivity();
+        return;
+    }
+    if (!_idle_shutdown_fired && _inactivity_expired(_cfg.idle_shutdown_ms)) {
+        _idle_shutdown_fired = true;
+        _dispatch(TrigShutdown);
+    }
+    if (!_idle_sleep_fired && _inactivity_expired(_cfg.idle_sleep_ms)) {
+        _idle_sleep_fired = true;
+        _dispatch(TrigSleep);
+    }
+    if (!_idle_eco_fired && _inactivity_expired(_cfg.idle_eco_ms)) {
+        _idle_eco_fired = true;
+        _dispatch(TrigEco);
+    }
+}
+
 // Map a POWER-switch gesture to its configured power action (see pbo_config_t).
 // User gestures (and anything else) return PboActionNone, i.e. forward to the app.
 static pbo_power_action_t _power_action_for(button_action_t btn_act)
@@ -456,6 +1524,32 @@ static pbo_power_action_t _power_action_for(button_action_t btn_act)
     }
 }
 
+// Trigger of a button event: its POWER action, otherwise forwarded to the app.
+static trigger_t _button_trigger(button_action_t btn_act)
+{
+    switch (_power_action_for(btn_act)) {
+        case PboActionSleep:    return TrigSleep;
+        case PboActionShutdown: return TrigShutdown;
+        case PboActionNone:
+        default:                return TrigButton;
+    }
+}
+
+// POWER gestures the state machine itself needs (mapped to a power action)
+static uint32_t _power_gestures_mapped()
+{
+    static const button_action_t power_gestures[] = {
+        ButtonPowerSingle, ButtonPowerDouble, ButtonPowerTriple, ButtonPowerLong, ButtonPowerLongLong
+    };
+    uint32_t mask = 0;
+    for (button_action_t btn_act : power_gestures) {
+        if (_power_action_for(btn_act) != PboActionNone) {
+            mask |= _gesture_bit(btn_act);
+        }
+    }
+    return mask;
+}
+
 // =========================================================================
 // Public functions (declaration order follows pico_battery_op.h)
 // =========================================================================
@@ -474,9 +1568,27 @@ pbo_config_t pbo_get_default_config()
         PboActionNone,                 // power_action_triple
         PboActionNone,                 // power_action_long
         PboActionShutdown,             // power_action_longlong
+        PBO_GESTURE_ALL,               // power_gestures
+        PBO_GESTURE_ALL,               // user_gestures
+        0,                             // idle_sleep_ms
+        0,                             // idle_shutdown_ms
+        0,                             // idle_eco_ms
+        true,                          // idle_suspend_on_usb
         DEFAULT_BATT_CALIB_COEF_A,     // batt_calib_coef_a
         DEFAULT_BATT_CALIB_COEF_B,     // batt_calib_coef_b
         DEFAULT_LOW_BATTERY_THRESHOLD, // low_battery_threshold
+        0,                             // low_battery_temp_comp_num
+        {},                            // low_battery_temp_comp
+        0,                             // battery_levels_num
+        {},                            // battery_levels
+        DEFAULT_LEVEL_HYSTERESIS_V,    // battery_level_hysteresis_v
+        DEFAULT_BATT_CHECK_MS,         // batt_check_min_ms
+        DEFAULT_BATT_CHECK_MS,         // batt_check_max_ms
+        DEFAULT_BATT_CHECK_MARGIN_V,   // batt_check_margin_v
+        false,                         // deep_sleep
+        0,                             // max_sleep_ms
+        PboStdioUartUsb,               // stdio
+        true,                          // usb_clock_gating
         {}                             // callbacks
     };
     return cfg;
@@ -486,6 +1598,8 @@ void pbo_init(const pbo_config_t* config)
 {
     _cfg = (config != nullptr) ? *config : pbo_get_default_config();
     _cb = _cfg.callbacks;
+    _power_gestures = _cfg.power_gestures | _power_gestures_mapped();
+    _user_gestures = _cfg.user_gestures;
 
     // Power Switch (Input) - also read below for the boot POWER_KEEP decision.
     gpio_init(_cfg.pin_power_sw);
@@ -495,6 +1609,12 @@ void pbo_init(const pbo_config_t* config)
     // USB Power detect Pin = Charge detect (Input) - also read for the boot decision.
     gpio_init(PIN_USB_POWER_DETECT);
     gpio_set_dir(PIN_USB_POWER_DETECT, GPIO_IN);
+#if !defined(ARDUINO)
+    // Both VBUS edges flag the USB clock domain / USB stdio for an update in pbo_process().
+    gpio_add_raw_irq_handler(PIN_USB_POWER_DETECT, _usb_power_irq);
+    gpio_set_irq_enabled(PIN_USB_POWER_DETECT, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, true);
+    irq_set_enabled(IO_IRQ_BANK0, true);
+#endif
 
     // Power Keep Pin (Output). Decide whether to come up running and drive POWER_KEEP to
     // that level BEFORE enabling output, so it is never pulsed low. On a warm reset while
@@ -506,14 +1626,37 @@ void pbo_init(const pbo_config_t* config)
     //                  reset released with no USB always restarts from OFF, regardless of
     //                  the prior state. (A powered-off board cannot boot at all, so RESET
     //                  can never turn it on - only the power switch or USB can.)
-    if (gpio_get(PIN_USB_POWER_DETECT)) {
+    //   deep Sleep wake -> keep running regardless of USB (the state is resumed).
+#if PICO_RP2350
+    wake_cause_t cause = WakePowerSwitch;
+    retained_t rec = {};
+    uint32_t slept_ms = 0;
+    _resumed = _cfg.deep_sleep && _deep_sleep_check_resume(&cause, &rec, &slept_ms);
+    bool restore_stats = _resumed;
+    if (_resumed && cause == WakeMaxSleep) {
+        // max_sleep_ms expired in a deep Sleep: boot as released (Stand-by, or Charging
+        // with USB) instead of resuming.
+        _resumed = false;
+    }
+#endif
+    if (_resumed) {
+        _boot_run = true;
+    } else if (gpio_get(PIN_USB_POWER_DETECT)) {
         _boot_run = false;
     } else {
         _boot_run = (gpio_get(_cfg.pin_power_sw) == false); // switch held == real power-on
     }
-    gpio_init(_cfg.pin_power_keep);
-    gpio_put(_cfg.pin_power_keep, _boot_run); // set level while still input (no low glitch)
-    gpio_set_dir(_cfg.pin_power_keep, GPIO_OUT);
+    if (_resumed) {
+        // POWER_KEEP is still latched high by pad isolation: drive SIO high first, so
+        // selecting the SIO function (which releases the isolation) never lets it go.
+        gpio_put(_cfg.pin_power_keep, true);
+        gpio_set_dir(_cfg.pin_power_keep, GPIO_OUT);
+        gpio_set_function(_cfg.pin_power_keep, GPIO_FUNC_SIO);
+    } else {
+        gpio_init(_cfg.pin_power_keep);
+        gpio_put(_cfg.pin_power_keep, _boot_run); // set level while still input (no low glitch)
+        gpio_set_dir(_cfg.pin_power_keep, GPIO_OUT);
+    }
 
     // User Switch (Input) - skipped when not wired (PBO_PIN_UNUSED)
     if (_cfg.pin_user_sw != PBO_PIN_UNUSED) {
@@ -537,9 +1680,28 @@ void pbo_init(const pbo_config_t* config)
     // button event queue
     queue_init(&btn_evt_queue, sizeof(element_t), QueueLength);
 
+    // First real battery value (and die temperature) before the sampler starts; the
+    // initial level is taken from it without a callback (see pbo_get_battery_level()).
+    _measure_battery_burst();
+    _batt_level = _battery_level_from(0);
+
     // Battery Check Timer start
     _timer_init_battery_check();
 
+#if PICO_RP2350
+    // Always-on clock for the dormant residency (left alone if the application runs it).
+    if (!aon_timer_is_running()) {
+        struct timespec ts = {};
+        aon_timer_start(&ts);
+    }
+#endif
+    pbo_reset_stats();
+#if PICO_RP2350
+    if (restore_stats) {
+        _deep_sleep_restore_stats(&rec, slept_ms);
+    }
+#endif
+
     // Serial start
     _start_serial();
 }
@@ -549,6 +1711,21 @@ float pbo_get_battery_voltage()
     return _bat_volt;
 }
 
+float pbo_get_die_temperature()
+{
+    return _die_temp;
+}
+
+float pbo_get_low_battery_threshold()
+{
+    return _low_battery_threshold(_die_temp);
+}
+
+uint32_t pbo_get_battery_level()
+{
+    return _batt_level;
+}
+
 bool pbo_get_usb_power_detected()
 {
     return gpio_get(PIN_USB_POWER_DETECT);
@@ -564,6 +1741,11 @@ bool pbo_is_caused_reboot()
     return watchdog_caused_reboot();
 }
 
+bool pbo_is_resumed_from_deep_sleep()
+{
+    return _resumed;
+}
+
 uint32_t pbo_get_dormant_reserved_pin_mask()
 {
     // GPIOs the library uses that an application low-leakage sweep must never touch: the
@@ -597,7 +1779,7 @@ void pbo_dormant_set_low_leakage(uint32_t app_hold_mask)
     //
     // NOTE: Pico / Pico 2 have <= 30 GPIOs, so this 32-bit mask covers all of bank 0; the loop is
     // capped at 32 to keep the shift well-defined on any larger package.
-    const uint32_t exclude = pbo_get_dormant_reserved_pin_mask() | app_hold_mask;
+    const uint32_t exclude = pbo_get_dormant_reserved_pin_mask() | _domains_hold_mask() | app_hold_mask;
     const uint32_t n = (NUM_BANK0_GPIOS < 32) ? NUM_BANK0_GPIOS : 32;
     for (uint32_t i = 0; i < n; i++) {
         if (exclude & (1u << i)) continue;
@@ -607,10 +1789,127 @@ void pbo_dormant_set_low_leakage(uint32_t app_hold_mask)
     }
 }
 
+int pbo_domain_register(const pbo_domain_t* domain)
+{
+    if (domain == nullptr || _num_domains >= PBO_MAX_DOMAINS) {
+        return -1;
+    }
+    _domains[_num_domains] = *domain;
+    return (int) _num_domains++;
+}
+
+void pbo_domains_power_up()
+{
+    if (_domains_up) {
+        return;
+    }
+    // Switch everything on first, so all settle times run concurrently.
+    uint64_t due_us[PBO_MAX_DOMAINS];
+    for (uint32_t i = 0; i < _num_domains; i++) {
+        _domain_set_power(&_domains[i], true);
+        due_us[i] = time_us_64() + (uint64_t) _domains[i].settle_ms * 1000;
+    }
+    // Then init in deadline order; an init that overruns the next deadline just makes the
+    // following one run without waiting.
+    uint32_t pending = (1u << _num_domains) - 1;
+    while (pending) {
+        uint32_t i = _domain_next(due_us, _num_domains, pending);
+        sleep_until(from_us_since_boot(due_us[i]));
+        if (_domains[i].init != nullptr) {
+            _domains[i].init();
+        }
+        pending &= ~(1u << i);
+    }
+    _domains_up = true;
+}
+
+bool pbo_domains_are_up()
+{
+    return _domains_up;
+}
+
+int pbo_timer_start(uint32_t period_ms, uint32_t slack_ms, pbo_timer_cb_t cb)
+{
+    if (period_ms == 0 || cb == nullptr) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < PBO_MAX_TIMERS; i++) {
+        if (_timers[i].cb == nullptr) {
+            _timers[i].period_ms = period_ms;
+            _timers[i].slack_ms = slack_ms;
+            _timers[i].due_ms = _now_ms() + period_ms;
+            _timers[i].cb = cb;
+            return (int) i;
+        }
+    }
+    return -1;
+}
+
+void pbo_timer_stop(int id)
+{
+    if (id >= 0 && id < (int) PBO_MAX_TIMERS) {
+        _timers[id].cb = nullptr;
+    }
+}
+
+uint32_t pbo_timer_next_due_ms()
+{
+    uint64_t fire_at = _timer_fire_at();
+    if (fire_at == UINT64_MAX) {
+        return UINT32_MAX;
+    }
+    uint64_t now_ms = _now_ms();
+    if (fire_at <= now_ms) {
+        return 0;
+    }
+    return (fire_at - now_ms < UINT32_MAX) ? (uint32_t) (fire_at - now_ms) : UINT32_MAX - 1;
+}
+
+void pbo_get_stats(pbo_stats_t* out)
+{
+    _stats_update();
+    if (out != nullptr) {
+        *out = _stats;
+    }
+}
+
+void pbo_reset_stats()
+{
+    _stats = {};
+    _stats_at = get_absolute_time();
+}
+
+float pbo_estimate_runtime_hours(const pbo_current_model_t* model, float capacity_mah)
+{
+#if !PICO_RP2350
+    (void) model;
+    (void) capacity_mah;
+    return PBO_RUNTIME_UNSUPPORTED; // sleep_ms / charging_ms stay 0 (see _dormant_clock_ms())
+#else
+    pbo_stats_t st;
+    pbo_get_stats(&st);
+    // Charge drawn over the recorded period [mA*ms], then the average current [mA].
+    float total_ms = (float) (st.idle_ms + st.active_ms + st.active_psm_ms + st.sleep_ms + st.charging_ms);
+    if (model == nullptr || total_ms <= 0) {
+        return 0;
+    }
+    float charge = (float) (st.idle_ms + st.active_ms) * model->active_ma
+                 + (float) st.active_psm_ms * model->active_psm_ma
+                 + (float) st.sleep_ms * model->sleep_ma
+                 + (float) st.charging_ms * model->charging_ma;
+    float average_ma = charge / total_ms;
+    if (average_ma <= 0) {
+        return 0;
+    }
+    return capacity_mah / average_ma;
+#endif
+}
+
 void pbo_start()
 {
     // Config and callbacks were already taken by pbo_init().
     _deferred = PboDeferredNone;
+    _deferred_queued = PboDeferredNone;
     // The initial PboStateIdle is the boot boundary; pbo_process() resolves it on
     // the first tick (USB -> Charging; no USB -> run only if the power switch was held at
     // boot, see pbo_init/_boot_run). The _boot flag scopes that rule to boot only, so a
@@ -618,71 +1917,98 @@ void pbo_start()
     _boot = true;
     _state = PboStateIdle;
     _state_prev = PboStateIdle;
-    _state_entered_at = get_absolute_time();
+    _state_entered_ms = _now_ms();
+    if (_resumed) {
+        // Wake-up from a deep Sleep: the state was PboStateActive before the power-down and
+        // POWER_KEEP is still held, so resume it directly (no boot boundary, no callback).
+        _boot = false;
+        _state = PboStateActive;
+        _state_prev = PboStateActive;
+    }
+    _eco_requested = false;
+    _activity_notified = false;
+    _usb_seen = pbo_get_usb_power_detected();
     // POWER_KEEP was already set to its correct boot level by pbo_init() (glitch-free);
     // do not drive it low here (a low pulse can brown-out the board on a warm reset).
 }
 
 void pbo_process()
 {
+    _stats_update();
+    _run_timers(_now_ms());
+    _update_battery_level();
+#if !defined(ARDUINO)
+    if (_usb_power_changed) {
+        _usb_power_changed = false;
+        _update_usb_serial();
+    }
+#endif
+
+    // PboStateActiveEco is left on any activity and entered on request.
+    bool usb = pbo_get_usb_power_detected();
+    if (usb != _usb_seen || _activity_notified) {
+        _usb_seen = usb;
+        _activity_notified = false;
+        _dispatch(TrigWake);
+    }
+    if (_eco_requested) {
+        _eco_requested = false;
+        _dispatch(TrigEco);
+    }
+
+    // A request queued behind a deferred action that was canceled begins now.
+    if (_deferred == PboDeferredNone && _deferred_queued != PboDeferredNone) {
+        pbo_deferred_reason_t reason = _deferred_queued;
+        _deferred_queued = PboDeferredNone;
+        _begin_defer(reason, _deferred_queued_ms);
+    }
+
     // While a deferred action is pending, forward button events to the
     // application (so it can pbo_cancel_deferred()) and run it at the deadline.
+    // Low battery is still evaluated: it preempts a pending Sleep / Shutdown.
     if (_deferred != PboDeferredNone) {
+        if (STATES[_state].running && _get_low_battery()) {
+            _dispatch(TrigLowBattery);
+        }
         button_action_t btn_act;
         if (_get_btn_evt(&btn_act)) {
+            _restart_inactivity();
+            _dispatch(TrigWake);
             if (_cb.on_button_event != nullptr) {
                 _cb.on_button_event(btn_act);
             }
         }
         _clear_btn_evt();
+        if (STATES[_state].running) {
+            _check_inactivity(); // e.g. the Shutdown timer preempts a Sleep announce
+        }
         if (_deferred != PboDeferredNone && time_reached(_defer_deadline)) {
             _run_deferred();
         }
         return;
     }
 
-    switch (_state) {
-        case PboStateActive: {
-            if (_get_low_battery()) {
-                _begin_defer(PboDeferredLowBattery, _cfg.shutdown_defer_ms);
-                break;
-            }
-            button_action_t btn_act;
-            if (_get_btn_evt(&btn_act)) {
-                switch (_power_action_for(btn_act)) {
-                    case PboActionSleep:
-                        _begin_defer(PboDeferredSleep, _cfg.sleep_defer_ms);
-                        break;
-                    case PboActionShutdown:
-                        _begin_defer(PboDeferredShutdown, _cfg.shutdown_defer_ms);
-                        break;
-                    case PboActionNone:
-                    default:
-                        // forward gestures not mapped to a power action
-                        if (_cb.on_button_event != nullptr) {
-                            _cb.on_button_event(btn_act);
-                        }
-                        break;
-                }
-            }
-            _clear_btn_evt();
-            break;
+    if (STATES[_state].running) {
+        if (_get_low_battery()) {
+            _dispatch(TrigLowBattery);
+            return;
         }
-        case PboStateIdle:
-            // Reached as the boot boundary, or via shutdown / low-battery commit.
-            //   USB present     : announce Charging, then dormant.
-            //   no USB & boot    : run only if the power switch was held at boot
-            //                      (_boot_run); otherwise POWER_KEEP released -> Stand-by.
-            //   no USB & !boot   : post-shutdown -> the hardware is powering off.
-            if (pbo_get_usb_power_detected()) {
-                _begin_defer(PboDeferredCharge, _cfg.charge_defer_ms);
-            } else if (_boot && _boot_run) {
-                _set_state(PboStateActive);
-            }
-            _boot = false; // the boot boundary is handled once
-            break;
-        default:
-            break;
+        button_action_t btn_act;
+        if (_get_btn_evt(&btn_act)) {
+            _restart_inactivity();
+            _dispatch(TrigWake);                              // leaves Eco
+            _dispatch(_button_trigger(btn_act), btn_act);     // power action, or forward
+        }
+        _clear_btn_evt();
+        _check_inactivity();
+    } else {
+        // PboStateIdle: reached as the boot boundary, or via shutdown / low-battery commit.
+        //   USB present     : announce Charging, then dormant.
+        //   no USB & boot    : run only if the power switch was held at boot
+        //                      (_boot_run); otherwise POWER_KEEP released -> Stand-by.
+        //   no USB & !boot   : post-shutdown -> the hardware is powering off.
+        _dispatch(pbo_get_usb_power_detected() ? TrigUsb : TrigNoUsb);
+        _boot = false; // the boot boundary is handled once
     }
 }
 
@@ -708,6 +2034,7 @@ bool pbo_get_deferred(pbo_deferred_info_t* out)
 bool pbo_cancel_deferred()
 {
     if (_deferred != PboDeferredNone && _deferred_cancelable(_deferred)) {
+        pbo_trace(PboTraceDeferCancel, _deferred);
         _deferred = PboDeferredNone;
         // The stable state was unchanged while pending, so nothing else to do.
         return true;
@@ -715,8 +2042,102 @@ bool pbo_cancel_deferred()
     return false;
 }
 
+void pbo_notify_activity()
+{
+    _restart_inactivity();
+    _activity_notified = true;
+}
+
+void pbo_request_eco()
+{
+    _eco_requested = true;
+}
+
 uint32_t pbo_get_state_elapsed_ms()
 {
-    int64_t elapsed_us = absolute_time_diff_us(_state_entered_at, get_absolute_time());
-    return (elapsed_us > 0) ? (uint32_t)(elapsed_us / 1000) : 0;
+    uint64_t elapsed_ms = _now_ms() - _state_entered_ms;
+    return (elapsed_ms < UINT32_MAX) ? (uint32_t) elapsed_ms : UINT32_MAX;
+}
+
+uint64_t pbo_get_wall_time_ms()
+{
+    return _now_ms();
+}
+
+uint64_t pbo_get_dormant_time_ms()
+{
+    return _dormant_total_ms;
 }
+
+#ifdef PBO_TRACE
+uint32_t pbo_trace_read(pbo_trace_record_t* out, uint32_t max)
+{
+    uint32_t n = 0;
+    uint32_t ints = save_and_disable_interrupts();
+    if (_trace_head - _trace_tail > TRACE_DEPTH) {
+        _trace_tail = _trace_head - TRACE_DEPTH; // overwritten records are lost
+    }
+    while (n < max && _trace_tail != _trace_head) {
+        out[n++] = _trace_ring[_trace_tail & (TRACE_DEPTH - 1)];
+        _trace_tail++;
+    }
+    restore_interrupts(ints);
+    return n;
+}
+
+void pbo_trace_dump()
+{
+    static const char* const names[] = {
+        "?", "state", "defer_begin", "defer_cancel", "defer_run",
+        "button", "button_dropped", "adc_mv", "dormant_enter", "dormant_exit",
+        "defer_preempt", "defer_queue", "batt_level"
+    };
+    pbo_trace_record_t rec;
+    uint32_t prev_us = 0;
+    bool first = true;
+    while (pbo_trace_read(&rec, 1) == 1) {
+        const char* name = (rec.event < sizeof(names) / sizeof(names[0])) ? names[rec.event] : names[0];
+        uint32_t delta_us = first ? 0 : rec.timestamp_us - prev_us;
+        printf("%10lu us (+%8lu) %-14s %lu\n", (unsigned long) rec.timestamp_us,
+               (unsigned long) delta_us, name, (unsigned long) rec.arg);
+        prev_us = rec.timestamp_us;
+        first = false;
+    }
+}
+#endif
+
+#ifdef PBO_BENCH
+void pbo_bench_timer_tick()
+{
+    _timer_callback_adc(&timer);
+}
+
+void pbo_bench_sample_battery()
+{
+    _monitor_battery_voltage();
+}
+
+void pbo_bench_set_state(pbo_state_t state)
+{
+    _set_state(state);
+}
+
+void pbo_bench_expire_timers()
+{
+    uint64_t now_ms = _now_ms();
+    for (uint32_t i = 0; i < PBO_MAX_TIMERS; i++) {
+        if (_timers[i].cb == nullptr) {
+            continue;
+        }
+        // window closed by now; clamped so it cannot wrap within slack_ms of boot
+        _timers[i].due_ms = (now_ms > _timers[i].slack_ms) ? now_ms - _timers[i].slack_ms : 0;
+    }
+    _run_timers(now_ms);
+}
+
+void pbo_bench_dormant_cycle()
+{
+    _set_state(PboStateActive);
+    _dormant_and_resume();
+}
+#endif
@@ -45,14 +45,23 @@ typedef enum {
 //                   powers off. Not a "running" state.
 //   PboStateActive : latch held, running. A Sleep just puts the CPU into dormant
 //                   mode while staying in PboStateActive; it is not a separate state.
+//   PboStateActiveEco : optional reduced-power PboStateActive (see pbo_config_t::idle_eco_ms
+//                   and pbo_request_eco()). Latch held, running; the app's on_enter_eco() /
+//                   on_exit_eco() hooks dim displays, lower clocks, etc. Any button event,
+//                   USB plug / unplug or pbo_notify_activity() returns to PboStateActive.
 typedef enum _pbo_state_t {
     PboStateIdle = 0,
-    PboStateActive
+    PboStateActive,
+    PboStateActiveEco
 } pbo_state_t;
 
 // A "deferred action" is a power action scheduled now and run automatically
 // after a delay, unless it is canceled (cancelable ones only) with
 // pbo_cancel_deferred() before its deadline.
+// Only one is pending at a time. A request of higher priority (LowBattery > Shutdown >
+// Sleep) preempts the pending one (a preempted Shutdown keeps its deadline if earlier); a
+// request of lower priority is queued behind it and begins only if the pending one is
+// canceled (it is dropped when the pending one runs).
 typedef enum _pbo_deferred_reason_t {
     PboDeferredNone = 0,
     PboDeferredSleep,        // PboStateActive -> dormant          (cancelable)
@@ -74,6 +83,36 @@ typedef enum _pbo_power_action_t {
     PboActionShutdown    // shut down       (schedules PboDeferredShutdown)
 } pbo_power_action_t;
 
+// One point of the low-battery threshold compensation over temperature (see
+// pbo_config_t::low_battery_temp_comp).
+typedef struct _pbo_temp_comp_point_t {
+    float temp_c;       // RP2 die temperature [degC]
+    float threshold_v;  // low-battery threshold at that temperature [V]
+} pbo_temp_comp_point_t;
+
+#define PBO_TEMP_COMP_MAX_POINTS 4
+
+#define PBO_MAX_BATTERY_LEVELS 4
+
+// Gesture enable bits (see pbo_config_t::power_gestures / user_gestures).
+#define PBO_GESTURE_SINGLE   (1u << 0)
+#define PBO_GESTURE_DOUBLE   (1u << 1)
+#define PBO_GESTURE_TRIPLE   (1u << 2)
+#define PBO_GESTURE_LONG     (1u << 3)
+#define PBO_GESTURE_LONGLONG (1u << 4)
+#define PBO_GESTURE_ALL      (PBO_GESTURE_SINGLE | PBO_GESTURE_DOUBLE | PBO_GESTURE_TRIPLE | \
+                              PBO_GESTURE_LONG | PBO_GESTURE_LONGLONG)
+
+// stdio the library brings up (see pbo_config_t::stdio). USB stdio is started only while
+// USB power is detected and stopped on unplug, so a battery-powered unit never runs the
+// USB stack. (Ignored under Arduino, whose core owns Serial.)
+typedef enum _pbo_stdio_t {
+    PboStdioNone = 0,
+    PboStdioUart,
+    PboStdioUsb,
+    PboStdioUartUsb
+} pbo_stdio_t;
+
 // Sentinel for pbo_config_t::pin_user_sw meaning "no user switch wired".
 // (GPIO0 therefore cannot be used as the user switch.)
 #define PBO_PIN_UNUSED 0u
@@ -82,11 +121,14 @@ typedef enum _pbo_power_action_t {
 // All members are optional (set to NULL to skip). They are called from
 // pbo_process() context (main-loop), never from an ISR.
 typedef struct _pbo_callbacks_t {
-    // A state transition occurred (PboStateIdle <-> PboStateActive). Note: a Sleep
-    // keeps PboStateActive (only the CPU goes dormant), so it does NOT fire this callback.
+    // A state transition occurred (PboStateIdle / PboStateActive / PboStateActiveEco). Note: a
+    // Sleep keeps PboStateActive (only the CPU goes dormant), so it does NOT fire this callback.
     void (*on_state_changed)(pbo_state_t new_state, pbo_state_t prev_state);
     // A deferred action was scheduled (its delay began).
     void (*on_deferred)(pbo_deferred_reason_t reason);
+    // A pending deferred action was preempted by one of higher priority (e.g. a Sleep
+    // announce by low battery). on_deferred(by) follows for the new action.
+    void (*on_deferred_preempted)(pbo_deferred_reason_t preempted, pbo_deferred_reason_t by);
     // Button events not consumed by the state machine as a power trigger: every user
     // gesture, plus any POWER gesture mapped to PboActionNone (see power_action_*).
     // While a deferred action is pending, all button events are forwarded here so the
@@ -95,8 +137,20 @@ typedef struct _pbo_callbacks_t {
     // Just before entering dormant mode (a Sleep or Charging); the app quiesces its
     // peripherals (e.g. display_deinit(), peripheral power off).
     void (*on_enter_dormant)();
-    // Just after waking from dormant mode. The state is already PboStateActive.
+    // Just after waking from dormant mode. The state is already PboStateActive. Not called
+    // when the wake ends in a shutdown instead (battery below the cutoff, measured on wake,
+    // or max_sleep_ms expiry).
     void (*on_exit_dormant)();
+    // Entering PboStateActiveEco: reduce power (dim the display, lower clk_sys, DC/DC to PFM).
+    void (*on_enter_eco)();
+    // Leaving PboStateActiveEco (to PboStateActive, before a Sleep, or to PboStateIdle):
+    // undo on_enter_eco().
+    void (*on_exit_eco)();
+    // The battery level changed (see pbo_config_t::battery_levels), in either direction; a
+    // fast drop can skip levels, so shed load by level >= n rather than level == n. The last
+    // level (battery_levels_num + 1) is the low-battery cutoff. May run right after a wake,
+    // before on_exit_dormant().
+    void (*on_battery_level)(uint32_t level, uint32_t prev_level);
 } pbo_callbacks_t;
 
 // Configuration passed to pbo_init(). Obtain defaults from pbo_get_default_config(),
@@ -117,17 +171,115 @@ typedef struct _pbo_config_t {
     pbo_power_action_t power_action_triple;    // default PboActionNone
     pbo_power_action_t power_action_long;      // default PboActionNone
     pbo_power_action_t power_action_longlong;  // default PboActionShutdown
+    // Gestures recognized per switch (PBO_GESTURE_* bits); disabled ones are never reported.
+    // POWER gestures mapped to a power action above are always enabled. Recognition waits
+    // only as long as the enabled gestures need: without Double / Triple, Single fires on
+    // release; without Double / Triple / Long / LongLong, it fires on press.
+    uint32_t power_gestures;    // default PBO_GESTURE_ALL
+    uint32_t user_gestures;     // default PBO_GESTURE_ALL
+    // Inactivity timers in PboStateActive (0 = disabled). Any button event, a wake from dormant
+    // and pbo_notify_activity() restart them; on expiry they schedule PboDeferredSleep /
+    // PboDeferredShutdown like the POWER gestures (same delays, same cancel).
+    uint32_t idle_sleep_ms;        // inactivity before a Sleep    (default 0)
+    uint32_t idle_shutdown_ms;     // inactivity before a Shutdown (default 0)
+    uint32_t idle_eco_ms;          // inactivity before PboStateActiveEco (default 0)
+    bool     idle_suspend_on_usb;  // hold the inactivity timers while USB is present (default true)
     // Battery ADC calibration (linear fit):
     //   battery_voltage[V] = adc_pin_voltage * batt_calib_coef_a + batt_calib_coef_b.
     // The ADC pin reads the battery through a 200k/100k divider (nominal ratio 3.0).
     float batt_calib_coef_a;        // scale from ADC pin voltage to battery voltage,
                                     // ideally the divider ratio, trimmed by measurement (default 2.9917)
     float batt_calib_coef_b;        // constant offset added after scaling, compensating divider/ADC bias [V] (default -0.020)
-    float low_battery_threshold;    // low-battery latch threshold [V] (default 2.9)
+    float low_battery_threshold;    // low-battery (shutdown) threshold [V] (default 2.9)
+    // Low-battery threshold over the RP2 die temperature (sampled with the battery voltage),
+    // for cells whose voltage sags in the cold: points sorted by ascending temp_c, linearly
+    // interpolated, held flat beyond the first / last point. low_battery_temp_comp_num = 0
+    // uses low_battery_threshold at any temperature. (default 0 points)
+    uint32_t low_battery_temp_comp_num;
+    pbo_temp_comp_point_t low_battery_temp_comp[PBO_TEMP_COMP_MAX_POINTS];
+    // Load-shedding battery levels above the low-battery threshold: battery_levels[] are
+    // thresholds [V] in descending order. Level 0 is above battery_levels[0], level i is below
+    // battery_levels[i - 1], and level battery_levels_num + 1 is below the low-battery
+    // threshold, which schedules PboDeferredLowBattery. A level is entered when a sample falls
+    // below its threshold and left when one is battery_level_hysteresis_v above it; every
+    // change calls on_battery_level(). (default 0 levels, 0.05 V)
+    uint32_t battery_levels_num;
+    float battery_levels[PBO_MAX_BATTERY_LEVELS];
+    float battery_level_hysteresis_v;
+    // Battery sampling interval, adapted after every sample: batt_check_max_ms with the cell
+    // full, shrinking with the headroom above the low-battery threshold and with the observed
+    // discharge rate, down to batt_check_min_ms within batt_check_margin_v of the threshold.
+    // Resolution is the 50 ms sampler tick. Equal min / max give a fixed interval.
+    uint32_t batt_check_min_ms;     // shortest interval [ms] (default 5000)
+    uint32_t batt_check_max_ms;     // longest interval [ms] (default 5000)
+    float batt_check_margin_v;      // headroom [V] below which batt_check_min_ms is used (default 0.1)
+    // RP2350 only: run a Sleep as a POWMAN power-down of the switched core instead of dormant.
+    // The chip wakes through reset on a POWER push and resumes in PboStateActive with
+    // POWER_KEEP still held (see pbo_is_resumed_from_deep_sleep()). Ignored on RP2040, which
+    // always uses dormant. Charging always uses dormant. The statistics (pbo_get_stats()) are
+    // carried over in whole seconds. (default false)
+    bool deep_sleep;
+    // RP2350 only: upper bound of a Sleep (0 = unbounded). When it expires without a POWER push,
+    // the library takes a battery sample and shuts down (PboStateIdle, POWER_KEEP released)
+    // without calling on_exit_dormant(). Ignored on RP2040, which has no clock running
+    // through dormant. (default 0)
+    uint32_t max_sleep_ms;
+    // stdio brought up by pbo_init() (see pbo_stdio_t). (default PboStdioUartUsb)
+    pbo_stdio_t stdio;
+    // Power down the USB clock domain while no USB power is detected: clk_usb stopped, clk_adc
+    // (and on RP2040 clk_rtc) moved to the XOSC, PLL_USB off; restored on USB plug-in before
+    // USB stdio starts. Turn it off if the application uses the USB controller or PLL_USB on
+    // its own. Ignored under Arduino, whose core owns USB. (default true)
+    bool usb_clock_gating;
     // Application callbacks (all optional; see pbo_callbacks_t).
     pbo_callbacks_t callbacks;
 } pbo_config_t;
 
+// Time spent in each power mode since pbo_init() / pbo_reset_stats() (see pbo_get_stats()).
+// The dormant residencies are measured with the RP2350 AON timer; on RP2040 nothing keeps
+// time through dormant, so sleep_ms / charging_ms stay 0 there (the counts are still valid).
+typedef struct _pbo_stats_t {
+    uint64_t idle_ms;         // running in PboStateIdle (boot boundary, Charging announce)
+    uint64_t active_ms;       // running in PboStateActive, DC/DC in PWM mode
+    uint64_t active_psm_ms;   // running in PboStateActive, DC/DC in PFM (power save) mode
+    uint64_t sleep_ms;        // dormant during a Sleep
+    uint64_t charging_ms;     // dormant during Charging
+    uint32_t sleep_count;     // number of Sleeps
+    uint32_t charging_count;  // number of Charging periods
+} pbo_stats_t;
+
+// pbo_estimate_runtime_hours() result where the estimate is not available (RP2040)
+#define PBO_RUNTIME_UNSUPPORTED (-1.0f)
+
+// Battery current drawn in each power mode, measured on the actual board (see
+// pbo_estimate_runtime_hours()). Running PboStateIdle is counted at active_ma.
+typedef struct _pbo_current_model_t {
+    float active_ma;          // PboStateActive, DC/DC in PWM mode [mA]
+    float active_psm_ma;      // PboStateActive, DC/DC in PFM mode [mA]
+    float sleep_ma;           // dormant during a Sleep [mA]
+    float charging_ma;        // drawn from the cell while Charging (normally 0) [mA]
+} pbo_current_model_t;
+
+// A peripheral power domain (see pbo_domain_register()): a load switch (or supply enable) and
+// the hooks that bring its peripheral up and down. The library switches the domain off before
+// dormant and on again after wake, overlapping the settle times of all domains.
+typedef struct _pbo_domain_t {
+    uint32_t pin_power;       // load-switch enable GPIO, PBO_PIN_UNUSED if always powered
+    bool power_active_low;    // pin_power level that switches the domain on is low
+    uint32_t hold_mask;       // GPIOs (bit i = GPIO i) kept through dormant besides pin_power
+                              // (see pbo_dormant_set_low_leakage())
+    uint32_t settle_ms;       // power-on to ready time of the peripheral [ms]
+    void (*init)();           // after the power settled: bring the peripheral up (optional)
+    void (*deinit)();         // before the power is cut: quiesce the peripheral (optional)
+} pbo_domain_t;
+
+#define PBO_MAX_DOMAINS 4
+
+// Software timer callback (see pbo_timer_start()); runs in pbo_process() context.
+typedef void (*pbo_timer_cb_t)();
+
+#define PBO_MAX_TIMERS 8
+
 // Return a config filled with default pin assignments, delays and
 // (NULL) callbacks. Override only the members you need, then pass to pbo_init().
 pbo_config_t pbo_get_default_config();
@@ -135,9 +287,21 @@ pbo_config_t pbo_get_default_config();
 // the pin assignments, so it must run before any other pbo_* call. Call first.
 void pbo_init(const pbo_config_t* config);
 float pbo_get_battery_voltage();
+// RP2 die temperature [degC] from the on-chip sensor, sampled together with the battery
+// voltage.
+float pbo_get_die_temperature();
+// Low-battery threshold [V] in effect at the last sampled die temperature.
+float pbo_get_low_battery_threshold();
+// Current battery level: 0 (above battery_levels[0]) .. battery_levels_num + 1 (below the
+// low-battery threshold). Valid after pbo_init().
+uint32_t pbo_get_battery_level();
 bool pbo_get_usb_power_detected();
 void pbo_reboot();
 bool pbo_is_caused_reboot();
+// True if this boot is the wake-up from a deep Sleep (see pbo_config_t::deep_sleep): the
+// application restarted from main(), while the library resumes directly in PboStateActive.
+// Valid after pbo_init().
+bool pbo_is_resumed_from_deep_sleep();
 
 // === Low-power (dormant) tuning ===
 // Bitmask (bit i = GPIO i) of the GPIOs the library must keep alive across dormant: the
@@ -145,15 +309,42 @@ bool pbo_is_caused_reboot();
 // library-owned pins. Use it to build a safe exclude mask when the application lowers pin
 // leakage for dormant, so it never disturbs the library's own pins.
 uint32_t pbo_get_dormant_reserved_pin_mask(void);
-// Put every GPIO that is neither reserved by the library (see above) nor listed in
-// app_hold_mask into the lowest-leakage state (pulls off, input buffer off, output driver
-// off) to minimize current while dormant. Call it just before entering dormant, typically
-// from the on_enter_dormant() callback. Pass in app_hold_mask any application pin that must
-// keep driving its level through dormant. This is destructive and does NOT save pad state:
-// the application must re-initialize the pins it let go (not in app_hold_mask) after wake,
+// Put every GPIO that is neither reserved by the library (see above), held by a registered
+// power domain (its pin_power and pbo_domain_t::hold_mask) nor listed in app_hold_mask into
+// the lowest-leakage state (pulls off, input buffer off, output driver off) to minimize
+// current while dormant. Call it just before entering dormant, typically from the
+// on_enter_dormant() callback. Pass in app_hold_mask any application pin that must keep
+// driving its level through dormant. This is destructive and does NOT save pad state: the
+// application must re-initialize the pins it let go (not in app_hold_mask) after wake,
 // typically in on_exit_dormant(). Uses only hardware_gpio (no pico_low_power dependency).
 void pbo_dormant_set_low_leakage(uint32_t app_hold_mask);
 
+// === Peripheral power domains ===
+// Register a peripheral power domain (the struct is copied). Returns its index, or -1 if
+// PBO_MAX_DOMAINS are already registered. Register before pbo_domains_power_up().
+int pbo_domain_register(const pbo_domain_t* domain);
+// Switch every registered domain on, then run each init() as soon as its settle_ms has
+// expired (earliest deadline first, waiting in low power in between), so bring-up takes about
+// the slowest settle_ms rather than the sum. Call once at boot; after each wake the library
+// calls it itself before on_exit_dormant(). Domains are switched off (deinit() in reverse
+// order, then pin_power) before on_enter_dormant(). No-op while the domains are up.
+void pbo_domains_power_up();
+// True while the domains are up: from pbo_domains_power_up() until the next dormant entry. A
+// wake that ends in PboStateIdle (e.g. the battery is below the cutoff) leaves them down, so
+// check it before using a peripheral behind a domain.
+bool pbo_domains_are_up();
+
+// === Statistics / battery-life estimate ===
+// Fill *out with the power-mode residency recorded so far (see pbo_stats_t).
+void pbo_get_stats(pbo_stats_t* out);
+// Clear the recorded residency (e.g. after a full charge, to measure one discharge).
+void pbo_reset_stats();
+// Predicted runtime [h] of a cell of capacity_mah, assuming the usage recorded in the stats
+// (the residency mix) continues with the per-mode currents of *model. Returns 0 if nothing
+// has been recorded yet, and PBO_RUNTIME_UNSUPPORTED on RP2040, where the dormant residency
+// cannot be measured: an estimate from running time alone would come out far too short.
+float pbo_estimate_runtime_hours(const pbo_current_model_t* model, float capacity_mah);
+
 // === Power state machine ===
 // Start the state machine: select the initial state from USB-plugged detection.
 // Call once after pbo_init() (which already took the config and callbacks).
@@ -169,8 +360,86 @@ bool pbo_get_deferred(pbo_deferred_info_t* out);
 // Cancel the pending deferred action if it is cancelable. Returns true if one
 // was actually canceled, false otherwise (none pending, or not cancelable).
 bool pbo_cancel_deferred();
-// Milliseconds elapsed since the current state was entered (for blink timing).
+// Report application activity (e.g. a sensor event or a host command): restarts the
+// inactivity timers (see pbo_config_t::idle_sleep_ms / idle_shutdown_ms) and leaves
+// PboStateActiveEco on the next pbo_process().
+void pbo_notify_activity();
+// Enter PboStateActiveEco on the next pbo_process() (only from PboStateActive).
+void pbo_request_eco();
+// Milliseconds elapsed since the current state was entered (for blink timing), dormant
+// periods included (see pbo_get_wall_time_ms()).
 uint32_t pbo_get_state_elapsed_ms();
+// Monotonic milliseconds since boot including the time spent dormant. The system timer
+// (get_absolute_time()) stops while dormant; the library adds each dormant period back as
+// measured on the RP2350 AON timer. On RP2040 nothing keeps time through dormant, so this
+// equals to_ms_since_boot(get_absolute_time()) there. Carried across a deep Sleep (see
+// pbo_config_t::deep_sleep) from the retained statistics.
+uint64_t pbo_get_wall_time_ms();
+// Total milliseconds spent dormant (Sleep and Charging) since boot; 0 on RP2040.
+uint64_t pbo_get_dormant_time_ms();
+
+// === Software timers ===
+// Call cb every period_ms from pbo_process(), at any point within slack_ms after it is due.
+// Expirations whose windows overlap are coalesced: when the earliest window closes, every
+// timer already due runs in the same pbo_process() call. Timers do not run while dormant, nor
+// hold it off or end it (only the Power switch / max_sleep_ms wake a Sleep); one that fell
+// behind runs once and restarts its period. Returns the timer id, or -1 if PBO_MAX_TIMERS are
+// already running (or period_ms is 0 / cb is NULL).
+int pbo_timer_start(uint32_t period_ms, uint32_t slack_ms, pbo_timer_cb_t cb);
+// Stop a timer started by pbo_timer_start() (may be called from its own callback).
+void pbo_timer_stop(int id);
+// Milliseconds until the next coalesced expiry (0 if it is already due), or UINT32_MAX if no
+// timer is running. The main loop may wait that long before calling pbo_process() again.
+uint32_t pbo_timer_next_due_ms();
+
+#ifdef PBO_TRACE
+// === Trace recorder (debug, built only with -DPBO_TRACE) ===
+// The library records its internal events into a fixed-size ring of binary records, cheap
+// enough for the 20 Hz sampler ISR (no printf, no allocation). The oldest records are
+// overwritten when the ring is full. Without PBO_TRACE none of this is compiled.
+typedef enum _pbo_trace_event_t {
+    PboTraceStateChange = 1, // arg: new_state | prev_state << 8
+    PboTraceDeferBegin,      // arg: pbo_deferred_reason_t
+    PboTraceDeferCancel,     // arg: pbo_deferred_reason_t
+    PboTraceDeferRun,        // arg: pbo_deferred_reason_t
+    PboTraceButton,          // arg: button_action_t (queued by the sampler)
+    PboTraceButtonDropped,   // arg: button_action_t (event queue was full)
+    PboTraceAdcSample,       // arg: battery voltage [mV]
+    PboTraceDormantEnter,    // arg: 0
+    PboTraceDormantExit,     // arg: wake cause (0: Power switch, 1: max_sleep_ms expiry)
+    PboTraceDeferPreempt,    // arg: new reason | preempted reason << 8
+    PboTraceDeferQueue,      // arg: pbo_deferred_reason_t (queued behind the pending one)
+    PboTraceBatteryLevel     // arg: new level | prev level << 8
+} pbo_trace_event_t;
+
+typedef struct _pbo_trace_record_t {
+    uint32_t timestamp_us; // time_us_32() when recorded
+    uint32_t event;        // pbo_trace_event_t
+    uint32_t arg;          // event-specific (see pbo_trace_event_t)
+} pbo_trace_record_t;
+
+// Move up to max of the oldest unread records into out[]; returns the number copied.
+uint32_t pbo_trace_read(pbo_trace_record_t* out, uint32_t max);
+// Print the unread records as a decoded timeline over stdio (consumes them). Call it from
+// the main loop, never from an ISR.
+void pbo_trace_dump();
+#endif
+
+#ifdef PBO_BENCH
+// === Benchmark hooks (samples/battery_op_bench and host/pbo_bench, built with -DPBO_BENCH) ===
+// Run one tick of the 20 Hz sampler body (button recognition + battery check), as the
+// repeating-timer ISR does.
+void pbo_bench_timer_tick();
+// Take one battery sample (ADC read and conversion), as done every battery check interval.
+void pbo_bench_sample_battery();
+// Force the stable state (enforces POWER_KEEP, fires on_state_changed) without the boot logic.
+void pbo_bench_set_state(pbo_state_t state);
+// Make every running software timer due now and run them, as pbo_process() does.
+void pbo_bench_expire_timers();
+// Go dormant as a Sleep from PboStateActive and resume, as a deferred Sleep does (host
+// benchmark: on target this blocks until the Power switch is pushed).
+void pbo_bench_dormant_cycle();
+#endif
 
 #ifdef __cplusplus
 }
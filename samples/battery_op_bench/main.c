@@ -0,0 +1,167 @@
+/*------------------------------------------------------/
+/ Copyright (c) 2026, Elehobica
+/ Released under the BSD-2-Clause
+/ refer to https://opensource.org/licenses/BSD-2-Clause
+/------------------------------------------------------*/
+
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/structs/systick.h"
+#include "hardware/sync.h"
+#include "pico_battery_op.h"
+
+#if PICO_RP2350
+#define PLATFORM_NAME "rp2350"
+#else
+#define PLATFORM_NAME "rp2040"
+#endif
+
+// Number of timed runs per case (odd, so the median is a single sample).
+#define NUM_RUNS 101
+
+// SysTick as a cycle counter (both RP2040 Cortex-M0+ and RP2350 Cortex-M33 have it):
+// 24-bit down counter clocked by the processor clock, no interrupt.
+#define SYSTICK_MAX     0x00ffffffu
+#define SYSTICK_CSR_RUN 0x5u         // ENABLE | CLKSOURCE (processor clock)
+
+static uint32_t samples[NUM_RUNS];
+static uint32_t overhead = 0; // cycles of an empty measurement, subtracted from each sample
+static bool first_case = true;
+
+static void cycles_init(void)
+{
+    systick_hw->csr = 0;
+    systick_hw->rvr = SYSTICK_MAX;
+    systick_hw->cvr = 0;
+    systick_hw->csr = SYSTICK_CSR_RUN;
+}
+
+// Cycles taken by one call of func, with interrupts off so the library's own sampler
+// (repeating timer) and USB cannot land inside the measurement.
+static uint32_t measure(void (*func)(void))
+{
+    uint32_t ints = save_and_disable_interrupts();
+    uint32_t start = systick_hw->cvr;
+    func();
+    uint32_t end = systick_hw->cvr;
+    restore_interrupts(ints);
+    uint32_t cycles = (start - end) & SYSTICK_MAX;
+    return (cycles > overhead) ? cycles - overhead : 0;
+}
+
+static void sort(uint32_t* a, int n)
+{
+    for (int i = 1; i < n; i++) {
+        uint32_t v = a[i];
+        int j = i - 1;
+        while (j >= 0 && a[j] > v) {
+            a[j + 1] = a[j];
+            j--;
+        }
+        a[j + 1] = v;
+    }
+}
+
+// Run a case NUM_RUNS times and print its min / median / max cycles as one JSON object.
+static void run_case(const char* name, void (*func)(void))
+{
+    for (int i = 0; i < NUM_RUNS; i++) {
+        samples[i] = measure(func);
+    }
+    sort(samples, NUM_RUNS);
+    uint32_t median = samples[NUM_RUNS / 2];
+    uint32_t clk_mhz = clock_get_hz(clk_sys) / 1000000;
+    printf("%s    {\"name\": \"%s\", \"min\": %lu, \"median\": %lu, \"max\": %lu, \"median_ns\": %lu}",
+           first_case ? "" : ",\n", name,
+           (unsigned long) samples[0], (unsigned long) median, (unsigned long) samples[NUM_RUNS - 1],
+           (unsigned long) (median * 1000 / clk_mhz));
+    first_case = false;
+}
+
+// === Cases ===============================================================
+static void case_empty(void)
+{
+}
+
+// Repeating-timer ISR body: _timer_callback_adc() -> _update_button_action() (+ battery check
+// once per interval, which shows up in max).
+static void case_timer_tick(void)
+{
+    pbo_bench_timer_tick();
+}
+
+// _monitor_battery_voltage(): ADC read and conversion.
+static void case_battery_sample(void)
+{
+    pbo_bench_sample_battery();
+}
+
+// pbo_process() in PboStateActive with nothing pending (the main-loop steady state).
+static void case_process_active(void)
+{
+    pbo_process();
+}
+
+static void timer_nop(void)
+{
+}
+
+// pbo_timer_start() + pbo_timer_stop() of one timer into a table with PBO_MAX_TIMERS - 1 running
+// (insert scans for the last free slot).
+static void case_timer_start(void)
+{
+    pbo_timer_stop(pbo_timer_start(1000, 100, timer_nop));
+}
+
+// One coalesced batch with PBO_MAX_TIMERS - 1 timers expiring together (fire-time scan, then
+// reschedule and an empty callback each).
+static void case_timer_expire(void)
+{
+    pbo_bench_expire_timers();
+}
+
+// Low-leakage sweep of every non-reserved GPIO. The stdio UART and LED pins are held so the
+// report can still be printed.
+static void case_low_leakage(void)
+{
+    pbo_dormant_set_low_leakage((1u << PICO_DEFAULT_UART_TX_PIN) | (1u << PICO_DEFAULT_UART_RX_PIN)
+                              | (1u << PICO_DEFAULT_LED_PIN));
+}
+
+int main(void)
+{
+    pbo_init(NULL); // Serial terminal also starts from here
+    // Run the state machine as PboStateActive directly: on a bare Pico, USB power would
+    // otherwise send the boot boundary into Charging (dormant).
+    pbo_bench_set_state(PboStateActive);
+    sleep_ms(3000); // time to open the serial terminal
+    for (int i = 0; i < PBO_MAX_TIMERS - 1; i++) {
+        pbo_timer_start(60 * 60 * 1000, 1000, timer_nop); // never due on their own while benchmarking
+    }
+
+    cycles_init();
+    overhead = 0;
+    overhead = measure(case_empty);
+
+    printf("{\n");
+    printf("  \"platform\": \"%s\",\n", PLATFORM_NAME);
+    printf("  \"clk_sys_hz\": %lu,\n", (unsigned long) clock_get_hz(clk_sys));
+    printf("  \"runs\": %d,\n", NUM_RUNS);
+    printf("  \"overhead\": %lu,\n", (unsigned long) overhead);
+    printf("  \"cases\": [\n");
+    run_case("timer_tick", case_timer_tick);
+    run_case("battery_sample", case_battery_sample);
+    run_case("process_active", case_process_active);
+    run_case("timer_start", case_timer_start);
+    run_case("timer_expire", case_timer_expire);
+    run_case("low_leakage", case_low_leakage);
+    printf("\n  ]\n}\n");
+
+    while (true) {
+        sleep_ms(1000);
+    }
+
+    return 0;
+}
@@ -12,6 +12,7 @@
 
 #include "ssd1306.h"
 #include "pico_battery_op.h"
+#include "view.h"
 
 // SSD1306 OLED display pins
 static const uint32_t PIN_I2C0_SDA      = 12;
@@ -19,49 +20,68 @@ static const uint32_t PIN_I2C0_SCL      = 13;
 static const uint32_t PIN_SSD1306_POWER = 14;
 
 static ssd1306_t disp;
+// framebuffer, shadow and async stream; retained in RAM through dormant (no heap per wake)
+static uint8_t disp_storage[SSD1306_STATIC_BUFSIZE(128, 64)];
+
+static bool disp_initialized = false;
 
 static uint32_t wakeup_count = 0;
 
-static inline uint32_t _millis(void)
-{
-	return to_ms_since_boot(get_absolute_time());
-}
+// Load shedding by battery level (see on_battery_level())
+static const float BATT_LEVEL_DIM_V    = 3.4; // below: dimmed display
+static const float BATT_LEVEL_NO_LED_V = 3.2; // below: LED off too
+static const uint8_t DISP_CONTRAST_FULL = 0xFF; // as set by the panel setup
+static const uint8_t DISP_CONTRAST_DIM  = 0x10;
+static uint32_t batt_level = 0;
+static uint8_t disp_contrast = DISP_CONTRAST_FULL;
 
-void display_power_init()
+// Uptime including Sleeps (the system timer stops while dormant)
+static inline uint32_t _millis(void)
 {
-    gpio_init(PIN_SSD1306_POWER);
-    gpio_disable_pulls(PIN_SSD1306_POWER);
-    gpio_set_dir(PIN_SSD1306_POWER, GPIO_OUT);
-    gpio_put(PIN_SSD1306_POWER, 0);
+	return (uint32_t) pbo_get_wall_time_ms();
 }
 
-void set_display_power(bool flag)
-{
-    if (flag) {
-        gpio_put(PIN_SSD1306_POWER, 1);
-    } else {
-        gpio_put(PIN_SSD1306_POWER, 0);
-    }
-}
-
-void display_init()
+void display_bus_init()
 {
     i2c_init(i2c0, 400000);
     gpio_set_function(PIN_I2C0_SDA, GPIO_FUNC_I2C);
     gpio_set_function(PIN_I2C0_SCL, GPIO_FUNC_I2C);
     gpio_disable_pulls(PIN_I2C0_SDA); // assume module has pull-up otherwise gpio_pull_up(PIN_I2C0_SDA);
     gpio_disable_pulls(PIN_I2C0_SCL); // assume module has pull-up otherwise gpio_pull_up(PIN_I2C0_SCL);
+}
+
+void display_init()
+{
+    display_bus_init();
 
     disp.external_vcc=false;
-    ssd1306_init(&disp, 128, 64, 0x3c, i2c0);
+    ssd1306_init_static(&disp, 128, 64, 0x3c, i2c0, disp_storage);
     ssd1306_poweron(&disp);
     ssd1306_clear(&disp);
 }
 
-void display_deinit()
+// After the panel power was cut: replay the panel setup and show the retained last frame.
+void display_resume()
+{
+    display_bus_init();
+    ssd1306_reinit(&disp);
+}
+
+void display_suspend()
 {
     ssd1306_poweroff(&disp);
-    ssd1306_deinit(&disp);
+}
+
+// Display power domain init: first bring-up at boot, retained frame after each wake.
+static void display_domain_init()
+{
+    if (disp_initialized) {
+        display_resume();
+    } else {
+        display_init();
+        disp_initialized = true;
+    }
+    disp_contrast = DISP_CONTRAST_FULL; // the main loop dims it again if needed
 }
 
 // === Power management callbacks (application side) =======================
@@ -73,31 +93,54 @@ static void on_button_event(button_action_t btn_act)
     }
 }
 
-// Quiesce the display and its power before the library enters dormant.
+// Battery level crossings (both directions; charging restores the features). Only recorded
+// here: this can run right after a wake, before the display is back.
+static void on_battery_level(uint32_t level, uint32_t prev_level)
+{
+    batt_level = level;
+    printf("battery level %lu -> %lu (%4.2f V)\n", (unsigned long) prev_level,
+           (unsigned long) level, pbo_get_battery_voltage());
+}
+
+// The library has already quiesced and switched off the display domain here.
 static void on_enter_dormant()
 {
-    display_deinit();
-    set_display_power(false);
-
-    // Minimize dormant current: put every GPIO except the library's reserved pins into the
-    // lowest-leakage state. This board holds no output through dormant, so app_hold_mask is
-    // 0; any pin that had to keep driving its level would go into that mask instead. The
-    // application pins let go here (LED, display power, I2C) are re-initialized after wake
-    // in on_exit_dormant().
+    // Minimize dormant current: put every GPIO except the library's reserved pins and the
+    // domain hold masks (the display power switch stays driven off) into the lowest-leakage
+    // state. The application pins let go here (LED, I2C) are re-initialized after wake: I2C
+    // by the display domain init, the LED in on_exit_dormant().
     pbo_dormant_set_low_leakage(0);
 }
 
-// Restore the application pins the low-leakage sweep let go, re-enable display power, then
-// re-initialize the display after waking.
+// The display domain is already back with its last frame here (power, settle, reinit by the
+// library); restore the LED pad the low-leakage sweep let go.
 static void on_exit_dormant()
 {
     wakeup_count++;
     gpio_init(PICO_DEFAULT_LED_PIN);
     gpio_set_dir(PICO_DEFAULT_LED_PIN, GPIO_OUT);
-    display_power_init();      // re-init the display-power pad (clears the sweep)
-    set_display_power(true);
-    sleep_ms(100); // wait for ssd1306 power stable
-    display_init();
+}
+
+static view_t make_view(uint32_t now, bool blink)
+{
+    view_t v = {};
+    v.state = pbo_get_state();
+    v.usb = pbo_get_usb_power_detected();
+    if (v.state == PboStateIdle) {
+        // latch released: only the charging indicator blinks while USB is present
+        v.blink = v.usb && blink;
+        return v;
+    }
+    pbo_deferred_info_t deferred;
+    v.has_deferred = pbo_get_deferred(&deferred);
+    if (v.has_deferred) {
+        v.reason = deferred.reason;
+        v.blink = blink;
+    }
+    v.sec = now / 1000;
+    v.centivolts = (uint32_t) (pbo_get_battery_voltage() * 100.0f + 0.5f);
+    v.wakeup_count = wakeup_count;
+    return v;
 }
 
 int main()
@@ -106,87 +149,89 @@ int main()
     gpio_init(PICO_DEFAULT_LED_PIN);
     gpio_set_dir(PICO_DEFAULT_LED_PIN, GPIO_OUT);
 
-    display_power_init();
+    // SSD1306 module behind a load switch: ~100 ms from power-on until it accepts commands
+    pbo_domain_t display_domain = {};
+    display_domain.pin_power = PIN_SSD1306_POWER;
+    display_domain.settle_ms = 100;
+    display_domain.init = display_domain_init;
+    display_domain.deinit = display_suspend;
+    pbo_domain_register(&display_domain);
 
     // Start from defaults, then override only what this board needs.
     pbo_config_t config = pbo_get_default_config();
     config.sleep_defer_ms    = 3000;  // 3 s announce before a Sleep (dormant)
     config.shutdown_defer_ms = 3000;  // 3 s announce before shutdown / low battery
     config.charge_defer_ms   = 3000;  // 3 s announce before charging (dormant)
+    config.battery_levels_num = 2;    // level 1: dim display, level 2: LED off, level 3: shutdown
+    config.battery_levels[0]  = BATT_LEVEL_DIM_V;
+    config.battery_levels[1]  = BATT_LEVEL_NO_LED_V;
     config.callbacks.on_button_event  = on_button_event;
     config.callbacks.on_enter_dormant = on_enter_dormant;
     config.callbacks.on_exit_dormant  = on_exit_dormant;
+    config.callbacks.on_battery_level = on_battery_level;
     pbo_init(&config); // Serial terminal also starts from here
+    batt_level = pbo_get_battery_level(); // starting level (no callback for it)
     printf("Battery Op. Demo\n");
 
     pbo_start();
-    set_display_power(true);
-    sleep_ms(100); // wait for ssd1306 power stable
-    display_init();
+    pbo_domains_power_up(); // display power, settle, display_init()
 
-    while (true) {
-        // Monitor
-        float battery_voltage = pbo_get_battery_voltage();
+    uint32_t frames = 0;
+    uint32_t report_at = _millis();
+    uint32_t report_bytes = disp.total_bytes;
+    view_t shown;
+    bool drawn = false;
 
+    while (true) {
         // Power state machine (library side; may block while dormant)
         pbo_process();
-        pbo_state_t power_state = pbo_get_state();
-        pbo_deferred_info_t deferred;
-        bool has_deferred = pbo_get_deferred(&deferred);
-        bool blink = (_millis() / 500) % 2 == 0; // 1 s period, 50% duty
-
-        char str[64];
-        ssd1306_clear(&disp);
-        ssd1306_draw_string(&disp, 8*0, 8*0, 1, (char*) "Battery Op. Demo");
-        if (power_state == PboStateIdle) {
-            // latch released: charging while USB is present
-            if (pbo_get_usb_power_detected() && blink) {
-                ssd1306_draw_string(&disp, 8*4, 8*4, 1, (char*) "Charging");
-            }
-        } else { // PboStateActive (running)
-            if (pbo_get_usb_power_detected()) {
-                ssd1306_draw_string(&disp, 8*0, 8*2, 1, (char*) "USB Power");
-                sprintf(str, "VSYS: %4.2f V", battery_voltage);
-            } else {
-                ssd1306_draw_string(&disp, 8*0, 8*2, 1, (char*) "Battery Power");
-                sprintf(str, "Battery: %4.2f V", battery_voltage);
-            }
-            ssd1306_draw_string(&disp, 8*0, 8*3, 1, str);
-            sprintf(str, "Wakeup: %lu", wakeup_count);
-            ssd1306_draw_string(&disp, 8*0, 8*5, 1, str);
-            // Announce the pending deferred power action.
-            if (has_deferred && blink) {
-                const char* msg = nullptr;
-                switch (deferred.reason) {
-                    case PboDeferredSleep:      msg = "GO DORMANT";  break;
-                    case PboDeferredShutdown:   msg = "SHUTDOWN";    break;
-                    case PboDeferredLowBattery: msg = "LOW BATTERY"; break;
-                    default:                 break;
-                }
-                if (msg != nullptr) {
-                    ssd1306_draw_string(&disp, 8*0, 8*6, 1, (char*) msg);
-                }
-            }
-            uint32_t millis = _millis();
-            uint32_t hour = millis / (1000 * 60 * 60);
-            uint32_t min = (millis / (1000 * 60)) % 60;
-            uint32_t sec = (millis / 1000) % 60;
-            sprintf(str, "%2d:%02d:%02d", hour, min, sec);
-            ssd1306_draw_string(&disp, 8*4, 8*7, 1, str);
+        uint32_t now = _millis();
+        bool blink = (now / 500) % 2 == 0; // 1 s period, 50% duty
+
+        // Redraw only when something visible changed (state, deferred, USB, displayed second,
+        // blink phase, voltage); ssd1306_show() then sends only the changed spans. Not while the
+        // display domain is down (a wake that ended in Idle leaves it off, its I2C bus dead).
+        view_t view = make_view(now, blink);
+        bool disp_up = pbo_domains_are_up();
+        if (disp_up && (!drawn || !view_equal(view, shown))) {
+            draw_view(&disp, view);
+            ssd1306_show(&disp);
+            shown = view;
+            drawn = true;
+            frames++;
+        }
+
+        // Shed load as the battery drops: dimmed display from level 1
+        uint8_t contrast = (batt_level >= 1) ? DISP_CONTRAST_DIM : DISP_CONTRAST_FULL;
+        if (disp_up && contrast != disp_contrast) {
+            ssd1306_contrast(&disp, contrast);
+            disp_contrast = contrast;
         }
-        ssd1306_show(&disp);
 
         // Main Process (Do something here)
         // Blink the LED at 1 Hz (driven by 'blink', not toggled per loop, which would
-        // run at the loop cadence ~5 Hz).
-        if (power_state == PboStateActive && !has_deferred) {
+        // run at the loop cadence), off from battery level 2.
+        if (view.state == PboStateActive && !view.has_deferred && batt_level < 2) {
             gpio_put(PICO_DEFAULT_LED_PIN, blink);
         } else {
             gpio_put(PICO_DEFAULT_LED_PIN, 0);
         }
 
-        // Loop wait
-        sleep_ms(100);
+        // Report the display cost once a minute
+        if (now - report_at >= 60 * 1000) {
+            uint32_t elapsed = now - report_at;
+            printf("display: %lu frames/min, %lu I2C bytes/min\n",
+                   (unsigned long) ((uint64_t) frames * 60000 / elapsed),
+                   (unsigned long) ((uint64_t) (disp.total_bytes - report_bytes) * 60000 / elapsed));
+            frames = 0;
+            report_at = now;
+            report_bytes = disp.total_bytes;
+        }
+
+        // Sleep until the next blink phase / second edge; the library's 20 Hz sampler interrupt
+        // wakes the core earlier, so button events are still handled promptly.
+        uint32_t next = (now / 500 + 1) * 500;
+        best_effort_wfe_or_timeout(make_timeout_time_ms(next - now));
     }
 
     return 0;
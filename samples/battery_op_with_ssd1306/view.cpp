@@ -0,0 +1,60 @@
+/*------------------------------------------------------/
+/ Copyright (c) 2026, Elehobica
+/ Released under the BSD-2-Clause
+/ refer to https://opensource.org/licenses/BSD-2-Clause
+/------------------------------------------------------*/
+
+#include <cinttypes>
+#include <cstdio>
+
+#include "view.h"
+
+bool view_equal(const view_t& a, const view_t& b)
+{
+    return a.state == b.state && a.usb == b.usb && a.has_deferred == b.has_deferred &&
+           a.reason == b.reason && a.blink == b.blink && a.sec == b.sec &&
+           a.centivolts == b.centivolts && a.wakeup_count == b.wakeup_count;
+}
+
+void draw_view(ssd1306_t* disp, const view_t& v)
+{
+    char str[64];
+    ssd1306_clear(disp);
+    ssd1306_draw_string(disp, 8*0, 8*0, 1, (char*) "Battery Op. Demo");
+    if (v.state == PboStateIdle) {
+        // latch released: charging while USB is present
+        if (v.blink) {
+            ssd1306_draw_string(disp, 8*4, 8*4, 1, (char*) "Charging");
+        }
+        return;
+    }
+    // PboStateActive (running)
+    if (v.usb) {
+        ssd1306_draw_string(disp, 8*0, 8*2, 1, (char*) "USB Power");
+        sprintf(str, "VSYS: %" PRIu32 ".%02" PRIu32 " V", v.centivolts / 100, v.centivolts % 100);
+    } else {
+        ssd1306_draw_string(disp, 8*0, 8*2, 1, (char*) "Battery Power");
+        sprintf(str, "Battery: %" PRIu32 ".%02" PRIu32 " V", v.centivolts / 100, v.centivolts % 100);
+    }
+    ssd1306_draw_string(disp, 8*0, 8*3, 1, str);
+    sprintf(str, "Wakeup: %" PRIu32, v.wakeup_count);
+    ssd1306_draw_string(disp, 8*0, 8*5, 1, str);
+    // Announce the pending deferred power action.
+    if (v.has_deferred && v.blink) {
+        const char* msg = nullptr;
+        switch (v.reason) {
+            case PboDeferredSleep:      msg = "GO DORMANT";  break;
+            case PboDeferredShutdown:   msg = "SHUTDOWN";    break;
+            case PboDeferredLowBattery: msg = "LOW BATTERY"; break;
+            default:                 break;
+        }
+        if (msg != nullptr) {
+            ssd1306_draw_string(disp, 8*0, 8*6, 1, (char*) msg);
+        }
+    }
+    uint32_t hour = v.sec / (60 * 60);
+    uint32_t min = (v.sec / 60) % 60;
+    uint32_t sec = v.sec % 60;
+    sprintf(str, "%2d:%02d:%02d", hour, min, sec);
+    ssd1306_draw_string(disp, 8*4, 8*7, 1, str);
+}
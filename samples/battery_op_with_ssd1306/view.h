@@ -0,0 +1,30 @@
+/*------------------------------------------------------/
+/ Copyright (c) 2026, Elehobica
+/ Released under the BSD-2-Clause
+/ refer to https://opensource.org/licenses/BSD-2-Clause
+/------------------------------------------------------*/
+
+// Screen content of the demo, kept apart from main.cpp so that the host benchmark
+// (host/ssd1306_bench.cpp) renders exactly the same frames.
+
+#pragma once
+
+#include <cstdint>
+
+#include "ssd1306.h"
+#include "pico_battery_op.h"
+
+// Everything the screen shows; fields that are not drawn in a state stay 0.
+struct view_t {
+    pbo_state_t state;
+    bool usb;
+    bool has_deferred;
+    pbo_deferred_reason_t reason;
+    bool blink;              // blink phase, only where something blinks
+    uint32_t sec;            // displayed uptime in seconds
+    uint32_t centivolts;     // displayed voltage (%4.2f)
+    uint32_t wakeup_count;
+};
+
+bool view_equal(const view_t& a, const view_t& b);
+void draw_view(ssd1306_t* disp, const view_t& v);
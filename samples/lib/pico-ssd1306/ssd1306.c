@@ -25,6 +25,7 @@ SOFTWARE.
 
 #include <pico/stdlib.h>
 #include <hardware/i2c.h>
+#include <hardware/dma.h>
 #include <pico/binary_info.h>
 #include <stdlib.h>
 #include <string.h>
@@ -47,12 +48,57 @@ inline static void fancy_write(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src
     }
 }
 
+inline static void ssd1306_xfer(ssd1306_t *p, const uint8_t *src, size_t len, char *name) {
+    ssd1306_wait(p);
+    fancy_write(p->i2c_i, p->address, src, len, name);
+    p->show_bytes+=len;
+    p->total_bytes+=len;
+    ++p->show_xfers;
+    ++p->total_xfers;
+}
+
+// send a command sequence as one transaction (a single 0x00 control byte, then the stream)
+static void ssd1306_write_cmds(ssd1306_t *p, const uint8_t *cmds, size_t len) {
+    uint8_t d[32];
+    d[0]=0x00;
+    memcpy(d+1, cmds, len);
+    ssd1306_xfer(p, d, len+1, "ssd1306_write");
+}
+
 inline static void ssd1306_write(ssd1306_t *p, uint8_t val) {
-    uint8_t d[2]= {0x00, val};
-    fancy_write(p->i2c_i, p->address, d, 2, "ssd1306_write");
+    ssd1306_write_cmds(p, &val, 1);
 }
 
-bool ssd1306_init(ssd1306_t *p, uint16_t width, uint16_t height, uint8_t address, i2c_inst_t *i2c_instance) {
+// Data transaction header that sets the GDDRAM window first: each addressing command byte is
+// preceded by a Co=1 command control byte (0x80), then 0x40 turns the rest into display data.
+static void ssd1306_window_header(ssd1306_t *p, uint8_t *d, uint32_t x0, uint32_t x1, uint32_t page0, uint32_t page1) {
+    uint8_t cmds[]= {SET_COL_ADDR, x0, x1, SET_PAGE_ADDR, page0, page1};
+    if(p->width==64) {
+        cmds[1]+=32;
+        cmds[2]+=32;
+    }
+
+    for(size_t i=0; i<sizeof(cmds); ++i) {
+        *d++=0x80;
+        *d++=cmds[i];
+    }
+    *d=0x40;
+}
+
+// widen the dirty column range of a page to cover x0..x1
+inline static void ssd1306_mark_dirty_page(ssd1306_t *p, uint32_t page, uint32_t x0, uint32_t x1) {
+    if(x0<p->dirty_x0[page]) p->dirty_x0[page]=x0;
+    if(x1>p->dirty_x1[page]) p->dirty_x1[page]=x1;
+}
+
+inline static void ssd1306_mark_clean(ssd1306_t *p) {
+    memset(p->dirty_x0, 0xff, sizeof(p->dirty_x0));
+    memset(p->dirty_x1, 0, sizeof(p->dirty_x1));
+}
+
+// mem: window header + framebuffer, then the shadow of the GDDRAM
+static void ssd1306_setup(ssd1306_t *p, uint16_t width, uint16_t height, uint8_t address, i2c_inst_t *i2c_instance,
+                          uint8_t *mem, uint16_t *txbuf, bool buffer_static) {
     p->width=width;
     p->height=height;
     p->pages=height/8;
@@ -62,15 +108,24 @@ bool ssd1306_init(ssd1306_t *p, uint16_t width, uint16_t height, uint8_t address
 
 
     p->bufsize=(p->pages)*(p->width);
-    if((p->buffer=malloc(p->bufsize+1))==NULL) {
-        p->bufsize=0;
-        return false;
-    }
-
-    ++(p->buffer);
+    p->buffer=mem+SSD1306_WINDOW_HEADER;
+    p->buffer_static=buffer_static;
+    p->shadow=p->buffer+p->bufsize;
+    p->shadow_valid=false;
+    ssd1306_mark_clean(p);
+    p->show_bytes=0;
+    p->total_bytes=0;
+    p->show_xfers=0;
+    p->total_xfers=0;
+    p->show_us=0;
+    p->dma_chan=-1;
+    p->txbuf=txbuf;
+}
 
+// panel command sequence; display_on=false leaves the panel off (GDDRAM can be filled first)
+static void ssd1306_send_init_cmds(ssd1306_t *p, bool display_on) {
 	// from https://github.com/makerportal/rpi-pico-ssd1306
-    int8_t cmds[]= {
+    uint8_t cmds[]= {
         SET_DISP | 0x00,  // off
         // address setting
         SET_MEM_ADDR,
@@ -79,12 +134,12 @@ bool ssd1306_init(ssd1306_t *p, uint16_t width, uint16_t height, uint8_t address
         SET_DISP_START_LINE | 0x00,
         SET_SEG_REMAP | 0x01,  // column addr 127 mapped to SEG0
         SET_MUX_RATIO,
-        height - 1,
+        p->height - 1,
         SET_COM_OUT_DIR | 0x08,  // scan from COM[N] to COM0
         SET_DISP_OFFSET,
         0x00,
         SET_COM_PIN_CFG,
-        width>2*height?0x02:0x12,
+        p->width>2*p->height?0x02:0x12,
         // timing and driving scheme
         SET_DISP_CLK_DIV,
         0x80,
@@ -100,17 +155,56 @@ bool ssd1306_init(ssd1306_t *p, uint16_t width, uint16_t height, uint8_t address
         // charge pump
         SET_CHARGE_PUMP,
         p->external_vcc?0x10:0x14,
-        SET_DISP | 0x01
+        SET_DISP | 0x01  // on (keep last)
     };
 
-    for(size_t i=0; i<sizeof(cmds); ++i)
-        ssd1306_write(p, cmds[i]);
+    ssd1306_write_cmds(p, cmds, display_on ? sizeof(cmds) : sizeof(cmds)-1);
+}
+
+bool ssd1306_init(ssd1306_t *p, uint16_t width, uint16_t height, uint8_t address, i2c_inst_t *i2c_instance) {
+    uint8_t *mem=malloc(2*(height/8)*width+SSD1306_WINDOW_HEADER);
+    if(mem==NULL) {
+        p->bufsize=0;
+        return false;
+    }
+
+    ssd1306_setup(p, width, height, address, i2c_instance, mem, NULL, false);
+    ssd1306_send_init_cmds(p, true);
+
+    return true;
+}
+
+bool ssd1306_init_static(ssd1306_t *p, uint16_t width, uint16_t height, uint8_t address, i2c_inst_t *i2c_instance, uint8_t *storage) {
+    // the async transmit stream follows the shadow, on the next 16-bit boundary
+    uint8_t *tx=storage+SSD1306_WINDOW_HEADER+2*(height/8)*width;
+    tx+=(uintptr_t) tx & 1;
+
+    ssd1306_setup(p, width, height, address, i2c_instance, storage, (uint16_t *) tx, true);
+    ssd1306_send_init_cmds(p, true);
 
     return true;
 }
 
+void ssd1306_reinit(ssd1306_t *p) {
+    ssd1306_cancel(p);
+    ssd1306_send_init_cmds(p, false);
+
+    // GDDRAM content was lost with the panel power: upload the retained frame, then light up
+    p->shadow_valid=false;
+    ssd1306_mark_clean(p);
+    ssd1306_show(p);
+    ssd1306_poweron(p);
+}
+
 inline void ssd1306_deinit(ssd1306_t *p) {
-    free(p->buffer-1);
+    ssd1306_cancel(p);
+    if(p->dma_chan>=0)
+        dma_channel_unclaim(p->dma_chan);
+    p->dma_chan=-1;
+    if(!p->buffer_static) {
+        free(p->txbuf);
+        free(p->buffer-SSD1306_WINDOW_HEADER);
+    }
 }
 
 inline void ssd1306_poweroff(ssd1306_t *p) {
@@ -122,8 +216,8 @@ inline void ssd1306_poweron(ssd1306_t *p) {
 }
 
 inline void ssd1306_contrast(ssd1306_t *p, uint8_t val) {
-    ssd1306_write(p, SET_CONTRAST);
-    ssd1306_write(p, val);
+    uint8_t cmds[]= {SET_CONTRAST, val};
+    ssd1306_write_cmds(p, cmds, sizeof(cmds));
 }
 
 inline void ssd1306_invert(ssd1306_t *p, uint8_t inv) {
@@ -132,37 +226,73 @@ inline void ssd1306_invert(ssd1306_t *p, uint8_t inv) {
 
 inline void ssd1306_clear(ssd1306_t *p) {
     memset(p->buffer, 0, p->bufsize);
+    for(uint32_t page=0; page<p->pages; ++page)
+        ssd1306_mark_dirty_page(p, page, 0, p->width-1);
+}
+
+void ssd1306_mark_dirty(ssd1306_t *p, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1) {
+    if(x0>x1 || y0>y1 || x0>=p->width || y0>=p->height)
+        return;
+    if(x1>=p->width) x1=p->width-1;
+    if(y1>=p->height) y1=p->height-1;
+    for(uint32_t page=y0>>3; page<=y1>>3; ++page)
+        ssd1306_mark_dirty_page(p, page, x0, x1);
 }
 
 void ssd1306_draw_pixel(ssd1306_t *p, uint32_t x, uint32_t y) {
 	if(x>=p->width || y>=p->height) return;
 
     p->buffer[x+p->width*(y>>3)]|=0x1<<(y&0x07); // y>>3==y/8 && y&0x7==y%8
+    ssd1306_mark_dirty_page(p, y>>3, x, x);
 }
 
+// Bresenham: one pixel per step along the major axis, so steep lines have no gaps
 void ssd1306_draw_line(ssd1306_t *p, int32_t x1, int32_t y1, int32_t x2, int32_t y2) {
-    if(x1>x2) {
-        uint32_t t=x1;
-        x1=x2;
-        x2=t;
-        t=y1;
-        y1=y2;
-        y2=t;
-    }
-
-    float m=(float) (y2-y1) / (float) (x2-x1);
-
-    for(int32_t i=x1; i<=x2; ++i) {
-        float y=m*(float) (i-x1)+(float) y1;
-        ssd1306_draw_pixel(p, (uint32_t) i, (uint32_t) y);
+    int32_t dx=x2>x1 ? x2-x1 : x1-x2;
+    int32_t dy=y2>y1 ? y1-y2 : y2-y1;
+    int32_t sx=x1<x2 ? 1 : -1;
+    int32_t sy=y1<y2 ? 1 : -1;
+    int32_t err=dx+dy;
+
+    for(;;) {
+        ssd1306_draw_pixel(p, (uint32_t) x1, (uint32_t) y1);
+        if(x1==x2 && y1==y2)
+            break;
+        int32_t e2=2*err;
+        if(e2>=dy) {
+            err+=dy;
+            x1+=sx;
+        }
+        if(e2<=dx) {
+            err+=dx;
+            y1+=sy;
+        }
     }
 }
 
 void ssd1306_draw_square(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t width, uint32_t height){
-	for(uint32_t i=0;i<width;++i)
-		for(uint32_t j=0;j<height;++j)
-			ssd1306_draw_pixel(p, x+i, y+j);
+    if(x>=p->width || y>=p->height || x+width<x || y+height<y) {
+        // coordinates wrapping around: keep the per-pixel semantics
+        for(uint32_t i=0;i<width;++i)
+            for(uint32_t j=0;j<height;++j)
+                ssd1306_draw_pixel(p, x+i, y+j);
+        return;
+    }
 
+    // OR a column mask into each page the rows y..y1-1 touch
+    uint32_t x1=x+width<p->width ? x+width : p->width;
+    uint32_t y1=y+height<p->height ? y+height : p->height;
+    if(x1==x || y1==y)
+        return;
+    for(uint32_t page=y>>3; page<=(y1-1)>>3; ++page) {
+        uint32_t r0=page*8>y ? 0 : y&7;
+        uint32_t r1=page*8+8<y1 ? 8 : y1-page*8;
+        uint8_t mask=(0xff<<r0) & (0xff>>(8-r1));
+        uint8_t *col=p->buffer+page*p->width;
+        for(uint32_t i=x; i<x1; ++i)
+            col[i]|=mask;
+        ssd1306_mark_dirty_page(p, page, x, x1-1);
+    }
 }
 
 void ssd13606_draw_empty_square(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t width, uint32_t height){
@@ -176,12 +306,47 @@ void ssd1306_draw_char_with_font(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t
     if(c > '~')
         return;
 
-    for(uint8_t i=0; i<font[1]; ++i) {
-        uint8_t line=(uint8_t)(font[(c-0x20)*font[1]+i+2]);
+    const uint8_t *glyph=font+(c-0x20)*font[1]+2;
+    uint8_t rows=font[0]<8 ? (1<<font[0])-1 : 0xff;
+
+    if(scale==1 && x<p->width && y<p->height) {
+        // a font column is a byte: shift it into one page (y on a page boundary) or two
+        uint32_t page=y>>3;
+        uint32_t shift=y&7;
+        uint32_t lastrow=p->height-1-y<7 ? p->height-1-y : 7;  // clip the rows below the display
+        uint8_t clip=rows & (0xff>>(7-lastrow));
+        uint32_t n=p->width-x<font[1] ? p->width-x : font[1];
+        uint8_t *upper=p->buffer+page*p->width+x;
+        uint8_t *lower=upper+p->width;
+        bool spill=shift && (clip<<shift)>0xff;
+
+        for(uint32_t i=0; i<n; ++i) {
+            uint32_t line=(uint32_t)(glyph[i] & clip)<<shift;
+            upper[i]|=line;
+            if(spill)
+                lower[i]|=line>>8;
+        }
+        ssd1306_mark_dirty_page(p, page, x, x+n-1);
+        if(spill)
+            ssd1306_mark_dirty_page(p, page+1, x, x+n-1);
+        return;
+    }
 
-        for(int8_t j=0; j<font[0]; ++j, line>>=1) {
-            if(line & 1 ==1)
-                ssd1306_draw_square(p, x+i*scale, y+j*scale, scale, scale);
+    // scaled: fill each vertical run of set bits as one rectangle
+    for(uint8_t i=0; i<font[1]; ++i) {
+        uint8_t line=glyph[i] & rows;
+
+        for(uint32_t j=0; line; ) {
+            if(!(line & 1)) {
+                ++j;
+                line>>=1;
+                continue;
+            }
+            uint32_t run=0;
+            for(; line & 1; line>>=1)
+                ++run;
+            ssd1306_draw_square(p, x+i*scale, y+j*scale, scale, run*scale);
+            j+=run;
         }
     }
 }
@@ -200,17 +365,162 @@ void ssd1306_draw_string(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t scale, c
     ssd1306_draw_string_with_font(p, x, y, scale, font_8x5, s);
 }
 
+// columns of a page drawn since the last show that differ from the display; false if none
+static bool ssd1306_changed_span(ssd1306_t *p, uint32_t page, uint32_t *x0, uint32_t *x1) {
+    if(p->dirty_x0[page]>p->dirty_x1[page])
+        return false;
+
+    const uint8_t *buf=p->buffer+page*p->width;
+    const uint8_t *shd=p->shadow+page*p->width;
+    int32_t l=p->dirty_x0[page];
+    int32_t r=p->dirty_x1[page];
+    while(l<=r && buf[l]==shd[l]) ++l;
+    while(r>=l && buf[r]==shd[r]) --r;
+    if(l>r)
+        return false;
+
+    *x0=l;
+    *x1=r;
+    return true;
+}
+
 void ssd1306_show(ssd1306_t *p) {
-    uint8_t payload[]= {SET_COL_ADDR, 0, p->width-1, SET_PAGE_ADDR, 0, p->pages-1};
-    if(p->width==64) {
-        payload[1]+=32;
-        payload[2]+=32;
+    uint32_t start=time_us_32();
+    p->show_bytes=0;
+    p->show_xfers=0;
+
+    if(!p->shadow_valid) {
+        // GDDRAM content is unknown after init: send the whole frame once
+        uint8_t *d=p->buffer-SSD1306_WINDOW_HEADER;
+        ssd1306_window_header(p, d, 0, p->width-1, 0, p->pages-1);
+
+        ssd1306_xfer(p, d, p->bufsize+SSD1306_WINDOW_HEADER, "ssd1306_show");
+        memcpy(p->shadow, p->buffer, p->bufsize);
+        p->shadow_valid=true;
+    } else {
+        uint8_t span[SSD1306_WINDOW_HEADER+128];
+        uint32_t x0, x1;
+        for(uint32_t page=0; page<p->pages; ++page) {
+            if(!ssd1306_changed_span(p, page, &x0, &x1))
+                continue;
+
+            size_t len=x1-x0+1;
+            const uint8_t *src=p->buffer+page*p->width+x0;
+            ssd1306_window_header(p, span, x0, x1, page, page);
+            memcpy(span+SSD1306_WINDOW_HEADER, src, len);
+            ssd1306_xfer(p, span, len+SSD1306_WINDOW_HEADER, "ssd1306_show");
+            memcpy(p->shadow+page*p->width+x0, src, len);
+        }
     }
+    ssd1306_mark_clean(p);
+    p->show_us=time_us_32()-start;
+}
+
+void ssd1306_dump_pbm(ssd1306_t *p) {
+    // plain PBM (P1): 1 is a lit pixel; rows split in lines of at most 64 pixels
+    printf("P1\n%u %u\n", p->width, p->height);
+    for(uint32_t y=0; y<p->height; ++y) {
+        const uint8_t *row=p->buffer+(y>>3)*p->width;
+        for(uint32_t x=0; x<p->width; ++x) {
+            putchar(row[x]>>(y&7) & 1 ? '1' : '0');
+            if((x&63)==63 || x==(uint32_t)p->width-1)
+                putchar('\n');
+        }
+    }
+}
+
+// append one i2c write transaction to a data_cmd stream: the window header, then src,
+// with STOP on the last byte so the controller starts a new transaction after it
+static uint16_t *ssd1306_put_txn(ssd1306_t *p, uint16_t *w, uint32_t x0, uint32_t x1, uint32_t page0, uint32_t page1, const uint8_t *src, size_t len) {
+    uint8_t header[SSD1306_WINDOW_HEADER];
+    ssd1306_window_header(p, header, x0, x1, page0, page1);
+    for(size_t i=0; i<SSD1306_WINDOW_HEADER; ++i)
+        *w++=header[i];
+    for(size_t i=0; i<len; ++i)
+        *w++=src[i];
+    *(w-1)|=I2C_IC_DATA_CMD_STOP_BITS;
+    ++p->show_xfers;
+    return w;
+}
+
+bool ssd1306_show_async(ssd1306_t *p) {
+    ssd1306_wait(p);
+    uint32_t start=time_us_32();
+    p->show_bytes=0;
+    p->show_xfers=0;
+
+    // worst case: one transaction per page
+    if(p->txbuf==NULL && (p->txbuf=malloc(p->pages*(SSD1306_WINDOW_HEADER+p->width)*sizeof(uint16_t)))==NULL)
+        return false;
+    if(p->dma_chan<0)
+        p->dma_chan=dma_claim_unused_channel(true);
+
+    // snapshot the changed spans into the stream; the framebuffer is free again right away
+    uint16_t *w=p->txbuf;
+    if(!p->shadow_valid) {
+        w=ssd1306_put_txn(p, w, 0, p->width-1, 0, p->pages-1, p->buffer, p->bufsize);
+        memcpy(p->shadow, p->buffer, p->bufsize);
+        p->shadow_valid=true;
+    } else {
+        uint32_t x0, x1;
+        for(uint32_t page=0; page<p->pages; ++page) {
+            if(!ssd1306_changed_span(p, page, &x0, &x1))
+                continue;
+            const uint8_t *src=p->buffer+page*p->width+x0;
+            w=ssd1306_put_txn(p, w, x0, x1, page, page, src, x1-x0+1);
+            memcpy(p->shadow+page*p->width+x0, src, x1-x0+1);
+        }
+    }
+    ssd1306_mark_clean(p);
+
+    size_t n=w-p->txbuf;
+    if(n==0) {
+        p->show_us=time_us_32()-start;
+        return true;
+    }
+    p->show_bytes=n;
+    p->total_bytes+=n;
+    p->total_xfers+=p->show_xfers;
+
+    i2c_hw_t *hw=i2c_get_hw(p->i2c_i);
+    hw->enable=0;
+    hw->tar=p->address;
+    hw->enable=1;
+
+    dma_channel_config c=dma_channel_get_default_config(p->dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, i2c_get_dreq(p->i2c_i, true));
+    dma_channel_configure(p->dma_chan, &c, &hw->data_cmd, p->txbuf, n, true);
+    p->show_us=time_us_32()-start;
+    return true;
+}
 
-    for(size_t i=0; i<sizeof(payload); ++i)
-        ssd1306_write(p, payload[i]);
+bool ssd1306_busy(ssd1306_t *p) {
+    if(p->dma_chan<0)
+        return false;
+    if(dma_channel_is_busy(p->dma_chan))
+        return true;
+    // the DMA is done once the last byte is in the FIFO; the bus is done once it drained
+    i2c_hw_t *hw=i2c_get_hw(p->i2c_i);
+    return !(hw->status & I2C_IC_STATUS_TFE_BITS) || (hw->status & I2C_IC_STATUS_MST_ACTIVITY_BITS);
+}
 
-    *(p->buffer-1)=0x40;
+void ssd1306_wait(ssd1306_t *p) {
+    while(ssd1306_busy(p))
+        tight_loop_contents();
+}
 
-    fancy_write(p->i2c_i, p->address, p->buffer-1, p->bufsize+1, "ssd1306_show");
+void ssd1306_cancel(ssd1306_t *p) {
+    if(!ssd1306_busy(p))
+        return;
+    dma_channel_abort(p->dma_chan);
+    i2c_hw_t *hw=i2c_get_hw(p->i2c_i);
+    hw->enable|=I2C_IC_ENABLE_ABORT_BITS;  // flush the TX FIFO and stop the bus
+    while(hw->enable & I2C_IC_ENABLE_ABORT_BITS)
+        tight_loop_contents();
+    (void) hw->clr_tx_abrt;
+    // the display holds a partial frame now
+    p->shadow_valid=false;
 }
@@ -56,6 +56,25 @@ typedef enum {
     SET_CHARGE_PUMP = 0x8D
 } ssd1306_command_t;
 
+/**
+*	@brief maximum number of pages (8 rows each) of a supported display (128x64)
+*/
+#define SSD1306_MAX_PAGES 8
+
+/**
+*	@brief bytes in front of a display data transaction that set its GDDRAM window
+*	(six addressing commands, each behind a 0x80 control byte, then the 0x40 data control byte)
+*/
+#define SSD1306_WINDOW_HEADER 13
+
+/**
+*	@brief size in bytes of the storage ssd1306_init_static() needs for a width x height display:
+*	window header, framebuffer, shadow and the ssd1306_show_async() transmit stream (16-bit
+*	words, plus a byte to align it)
+*/
+#define SSD1306_STATIC_BUFSIZE(width, height) \
+    (SSD1306_WINDOW_HEADER+2*(width)*((height)/8)+1+2*((height)/8)*(SSD1306_WINDOW_HEADER+(width)))
+
 /**
 *	@brief holds the configuration
 */
@@ -66,8 +85,20 @@ typedef struct {
     uint8_t address; 	/**< i2c address of display*/
     i2c_inst_t *i2c_i; 	/**< i2c connection instance */
     bool external_vcc; 	/**< whether display uses external vcc */ 
-    uint8_t *buffer;	/**< display buffer */
+    uint8_t *buffer;	/**< display buffer; after writing it directly, call ssd1306_mark_dirty() or ssd1306_show() skips the change */
     size_t bufsize;		/**< buffer size */
+    bool buffer_static;	/**< buffer provided by ssd1306_init_static() (not freed by deinit) */
+    uint8_t *shadow;	/**< copy of what was last sent to the display (GDDRAM) */
+    bool shadow_valid;	/**< false until the first ssd1306_show() after init (GDDRAM unknown) */
+    uint8_t dirty_x0[SSD1306_MAX_PAGES];	/**< first column drawn since last show per page (0xff: clean) */
+    uint8_t dirty_x1[SSD1306_MAX_PAGES];	/**< last column drawn since last show per page */
+    uint32_t show_bytes;	/**< i2c bytes sent by the last ssd1306_show() (0 if nothing changed) */
+    uint32_t total_bytes;	/**< i2c bytes sent since init */
+    uint32_t show_xfers;	/**< i2c transactions of the last ssd1306_show() */
+    uint32_t total_xfers;	/**< i2c transactions since init (init itself is one) */
+    uint32_t show_us;		/**< time spent in the last ssd1306_show() / ssd1306_show_async() call (us) */
+    int dma_chan;		/**< DMA channel of ssd1306_show_async() (-1: not claimed yet) */
+    uint16_t *txbuf;	/**< i2c data_cmd stream of ssd1306_show_async() (allocated on first use) */
 } ssd1306_t;
 
 #ifdef __cplusplus
@@ -89,6 +120,39 @@ extern "C" {
 */
 bool ssd1306_init(ssd1306_t *p, uint16_t width, uint16_t height, uint8_t address, i2c_inst_t *i2c_instance);
 
+/**
+*	@brief initialize display on caller-provided storage (no heap use)
+*
+*	Same as ssd1306_init(), but the framebuffer, its shadow and the
+*	ssd1306_show_async() transmit stream live in storage, e.g.
+*	static uint8_t storage[SSD1306_STATIC_BUFSIZE(128, 64)].
+*	ssd1306_deinit() does not free it.
+*
+*	@param[in] p : pointer to instance of ssd1306_t
+*	@param[in] width : width of display
+*	@param[in] height : heigth of display
+*	@param[in] address : i2c address of display
+*	@param[in] i2c_instance : instance of i2c connection
+*	@param[in] storage : SSD1306_STATIC_BUFSIZE(width, height) bytes
+*
+* 	@return bool.
+*	@retval true for Success
+*/
+bool ssd1306_init_static(ssd1306_t *p, uint16_t width, uint16_t height, uint8_t address, i2c_inst_t *i2c_instance, uint8_t *storage);
+
+/**
+*	@brief re-initialize the panel after its power was cut, keeping the framebuffer
+*
+*	Replays the panel command sequence, uploads the framebuffer (e.g. the last
+*	frame before the power was cut) and turns the display on, so it shows
+*	again without a redraw. The i2c instance must be initialized again first.
+*	Contrast and invert return to their init defaults.
+*
+*	@param[in] p : instance of display
+*
+*/
+void ssd1306_reinit(ssd1306_t *p);
+
 /**
 *	@brief deinitialize display
 *
@@ -134,11 +198,69 @@ void ssd1306_invert(ssd1306_t *p, uint8_t inv);
 /**
 	@brief display buffer, should be called on change
 
+	Only the columns drawn (or marked with ssd1306_mark_dirty()) since the last
+	call that actually differ from what the display already shows are sent (one window per page); nothing is sent if
+	nothing changed. Each span is a single i2c transaction that sets its window
+	and carries the data. See show_bytes / show_xfers (and the totals) for the
+	bus traffic.
+
 	@param[in] p : instance of display
 
 */
 void ssd1306_show(ssd1306_t *p);
 
+/**
+	@brief display buffer without blocking
+
+	Same as ssd1306_show(), but the changed spans are snapshot into a transmit
+	stream that a DMA channel feeds to the i2c TX FIFO (paced by its DREQ), so
+	the caller can draw the next frame while it is sent. Waits for a previous
+	transfer first. Any other call on the display also waits for it.
+
+	@param[in] p : instance of display
+
+	@return bool.
+	@retval true if the transfer was started (or nothing had changed)
+	@retval false if the transmit stream could not be allocated
+*/
+bool ssd1306_show_async(ssd1306_t *p);
+
+/**
+	@brief whether a ssd1306_show_async() transfer is still in flight
+
+	@param[in] p : instance of display
+
+*/
+bool ssd1306_busy(ssd1306_t *p);
+
+/**
+	@brief wait until a ssd1306_show_async() transfer has completed
+
+	@param[in] p : instance of display
+
+*/
+void ssd1306_wait(ssd1306_t *p);
+
+/**
+	@brief cancel a ssd1306_show_async() transfer in flight (e.g. before powering
+	the display off). The next ssd1306_show() then resends the whole frame.
+
+	@param[in] p : instance of display
+
+*/
+void ssd1306_cancel(ssd1306_t *p);
+
+/**
+	@brief print the display buffer to stdout as a plain PBM (P1) image
+
+	Capture the serial output to a .pbm file to inspect a frame off-target or
+	compare it with a reference frame.
+
+	@param[in] p : instance of display
+
+*/
+void ssd1306_dump_pbm(ssd1306_t *p);
+
 /**
 	@brief clear display buffer
 
@@ -147,6 +269,22 @@ void ssd1306_show(ssd1306_t *p);
 */
 void ssd1306_clear(ssd1306_t *p);
 
+/**
+	@brief mark a rectangle of the buffer as changed
+
+	The drawing functions do this themselves. Call it after writing p->buffer
+	directly, or the next ssd1306_show() does not send the change. Corners are
+	inclusive and clipped to the display; (0, 0, width-1, height-1) marks the
+	whole frame.
+
+	@param[in] p : instance of display
+	@param[in] x0 : left column
+	@param[in] y0 : top row
+	@param[in] x1 : right column
+	@param[in] y1 : bottom row
+*/
+void ssd1306_mark_dirty(ssd1306_t *p, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1);
+
 /**
 	@brief draw pixel on buffer
 